@@ -1,5 +1,6 @@
 #pragma once
 #include "Object3D.h"
+#include "ObjectStore.h"
 
 /**
 * @brief Represents an abstract animation of an object, manipulating one or more of its
@@ -10,7 +11,9 @@ class Animation {
 private:
 	float_t m_duration;
 	float_t m_currentTime;
-	Object3D& m_object;
+	ObjectRef m_target;
+	// The target, resolved against the store at the start of each start() and tick().
+	Object3D* m_object;
 
 	/**
 	 * @brief Called when the animation is activated by an Animator.
@@ -23,8 +26,8 @@ private:
 	virtual void applyAnimation(float_t dt) = 0;
 
 public:
-	Animation(Object3D& obj, float_t duration) : m_object(obj), m_duration(duration),
-		m_currentTime(-1) {
+	Animation(ObjectRef target, float_t duration) : m_target(std::move(target)), m_object(nullptr),
+		m_duration(duration), m_currentTime(-1) {
 	}
 
 	/**
@@ -38,24 +41,37 @@ public:
 	float_t currentTime() const { return m_currentTime; }
 
 	/**
-	* @brief The object the animation is manipulating.
+	* @brief The object the animation is manipulating. Only valid inside startAnimation and
+	* applyAnimation.
 	*/
-	Object3D& object() const { return m_object; }
+	Object3D& object() const { return *m_object; }
 
 	/**
-	* @brief Advances the animation by the given interval, in seconds.
+	 * @brief The reference to the object the animation is manipulating.
+	 */
+	const ObjectRef& target() const { return m_target; }
+
+	/**
+	* @brief Advances the animation by the given interval, in seconds. If the target no longer
+	* exists in the store, time still passes but nothing is applied.
 	*/
-	void tick(float_t dt) {
+	void tick(float_t dt, ObjectStore& objects) {
 		m_currentTime += dt;
-		applyAnimation(dt);
+		m_object = m_target.resolve(objects);
+		if (m_object != nullptr) {
+			applyAnimation(dt);
+		}
 	}
 
 	/**
 	 * @brief Starts the animation.
 	 */
-	void start() {
+	void start(ObjectStore& objects) {
 		m_currentTime = 0;
-		startAnimation();
+		m_object = m_target.resolve(objects);
+		if (m_object != nullptr) {
+			startAnimation();
+		}
 	}
 
 };
@@ -0,0 +1,41 @@
+#include "AnimationClip.h"
+
+KeyframeTrack<glm::vec3>& AnimationClip::position() {
+	return m_position;
+}
+
+KeyframeTrack<glm::vec3>& AnimationClip::orientation() {
+	return m_orientation;
+}
+
+KeyframeTrack<glm::vec3>& AnimationClip::scale() {
+	return m_scale;
+}
+
+const KeyframeTrack<glm::vec3>& AnimationClip::position() const {
+	return m_position;
+}
+
+const KeyframeTrack<glm::vec3>& AnimationClip::orientation() const {
+	return m_orientation;
+}
+
+const KeyframeTrack<glm::vec3>& AnimationClip::scale() const {
+	return m_scale;
+}
+
+float_t AnimationClip::duration() const {
+	return std::max({ m_position.duration(), m_orientation.duration(), m_scale.duration() });
+}
+
+void AnimationClip::apply(Object3D& object, float_t time) const {
+	if (!m_position.empty()) {
+		object.setPosition(m_position.sample(time));
+	}
+	if (!m_orientation.empty()) {
+		object.setOrientation(m_orientation.sample(time));
+	}
+	if (!m_scale.empty()) {
+		object.setScale(m_scale.sample(time));
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "KeyframeTrack.h"
+#include "Object3D.h"
+
+/**
+ * @brief A keyframed animation of an object's position, orientation and scale. Each track is
+ * optional; an empty track leaves that attribute alone. The clip is sampled at an absolute time,
+ * so the pose at any time is exact and independent of how the time was reached.
+ */
+class AnimationClip {
+private:
+	KeyframeTrack<glm::vec3> m_position;
+	KeyframeTrack<glm::vec3> m_orientation;
+	KeyframeTrack<glm::vec3> m_scale;
+
+public:
+	AnimationClip() = default;
+
+	// Track access, for adding keys.
+	KeyframeTrack<glm::vec3>& position();
+	KeyframeTrack<glm::vec3>& orientation();
+	KeyframeTrack<glm::vec3>& scale();
+	const KeyframeTrack<glm::vec3>& position() const;
+	const KeyframeTrack<glm::vec3>& orientation() const;
+	const KeyframeTrack<glm::vec3>& scale() const;
+
+	/**
+	 * @brief The time of the last key in any track.
+	 */
+	float_t duration() const;
+
+	/**
+	 * @brief Poses the object as the clip describes it at the given time.
+	 */
+	void apply(Object3D& object, float_t time) const;
+};
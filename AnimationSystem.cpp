@@ -0,0 +1,88 @@
+#include "AnimationSystem.h"
+#include <algorithm>
+
+void AnimationSystem::ChannelArray::add(ObjectRef target, float_t start, float_t duration, const glm::vec3& total) {
+	targets.push_back(std::move(target));
+	starts.push_back(start);
+	if (duration > 0) {
+		ends.push_back(start + duration);
+		rates.push_back(total / duration);
+	}
+	else {
+		// An instant channel has no rate to spread; it applies its whole change at once.
+		ends.push_back(start);
+		rates.push_back(total);
+	}
+	deltas.emplace_back(0);
+}
+
+bool AnimationSystem::ChannelArray::active(size_t i, float_t from, float_t to) const {
+	return starts[i] < to && (ends[i] > from || starts[i] >= from);
+}
+
+void AnimationSystem::ChannelArray::evaluate(float_t from, float_t to) {
+	size_t count = targets.size();
+	const float_t* s = starts.data();
+	const float_t* e = ends.data();
+	const glm::vec3* r = rates.data();
+	glm::vec3* d = deltas.data();
+	for (size_t i = 0; i < count; i++) {
+		// The length of the overlap between the tick and the channel's window; zero if none.
+		float_t overlap = std::max(0.0f, std::min(to, e[i]) - std::max(from, s[i]));
+		d[i] = e[i] > s[i] ? r[i] * overlap : r[i];
+	}
+}
+
+float_t AnimationSystem::addTranslation(ObjectRef object, float_t start, float_t duration,
+	const glm::vec3& totalMovement) {
+	m_translations.add(std::move(object), start, duration, totalMovement);
+	float_t end = start + std::max(duration, 0.0f);
+	m_duration = std::max(m_duration, end);
+	return end;
+}
+
+float_t AnimationSystem::addRotation(ObjectRef object, float_t start, float_t duration,
+	const glm::vec3& totalRotation) {
+	m_rotations.add(std::move(object), start, duration, totalRotation);
+	float_t end = start + std::max(duration, 0.0f);
+	m_duration = std::max(m_duration, end);
+	return end;
+}
+
+void AnimationSystem::start() {
+	m_currentTime = 0;
+	m_running = true;
+}
+
+void AnimationSystem::tick(float_t dt, ObjectStore& objects) {
+	if (!m_running) {
+		return;
+	}
+	float_t from = m_currentTime;
+	m_currentTime += dt;
+
+	m_translations.evaluate(from, m_currentTime);
+	m_rotations.evaluate(from, m_currentTime);
+
+	for (size_t i = 0; i < m_translations.size(); i++) {
+		if (m_translations.active(i, from, m_currentTime)) {
+			Object3D* target = m_translations.targets[i].resolve(objects);
+			if (target != nullptr) {
+				target->move(m_translations.deltas[i]);
+			}
+		}
+	}
+	for (size_t i = 0; i < m_rotations.size(); i++) {
+		if (m_rotations.active(i, from, m_currentTime)) {
+			Object3D* target = m_rotations.targets[i].resolve(objects);
+			if (target != nullptr) {
+				target->rotate(m_rotations.deltas[i]);
+			}
+		}
+	}
+
+	// Once every channel has finished there is nothing left to do.
+	if (from >= m_duration) {
+		m_running = false;
+	}
+}
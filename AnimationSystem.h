@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include "ObjectStore.h"
+
+/**
+ * @brief Plays many simple animations at once from flat arrays, instead of one heap-allocated
+ * Animation per step behind a virtual call. Every channel is scheduled on the system's own clock
+ * with an absolute start and end time, so a sequence is just channels placed back to back and a
+ * pause is just a gap between them; pauses take no storage at all.
+ *
+ * Each tick runs one branch-free loop per channel type that works out how much of each channel's
+ * window the tick covered, then one loop that applies the results to the target objects.
+ */
+class AnimationSystem {
+private:
+	/**
+	 * @brief The channels of one type, stored as parallel arrays.
+	 */
+	struct ChannelArray {
+		std::vector<ObjectRef> targets;
+		std::vector<float_t> starts;
+		std::vector<float_t> ends;
+		// The change applied per second while the channel is active, or for an instant channel
+		// (one whose end is its start) the whole change.
+		std::vector<glm::vec3> rates;
+		// Scratch: the change to apply this tick.
+		std::vector<glm::vec3> deltas;
+
+		void add(ObjectRef target, float_t start, float_t duration, const glm::vec3& total);
+		/**
+		 * @brief Fills deltas with each channel's change over the interval [from, to].
+		 */
+		void evaluate(float_t from, float_t to);
+		/**
+		 * @brief Whether channel i changes its target during the tick [from, to). An instant
+		 * channel does so on the one tick that reaches its start.
+		 */
+		bool active(size_t i, float_t from, float_t to) const;
+		size_t size() const { return targets.size(); }
+	};
+
+	ChannelArray m_translations;
+	ChannelArray m_rotations;
+	float_t m_currentTime;
+	float_t m_duration;
+	bool m_running;
+
+public:
+	AnimationSystem() : m_currentTime(0), m_duration(0), m_running(false) {}
+
+	/**
+	 * @brief Moves the object by the given total translation, evenly over [start, start + duration].
+	 * With a duration of zero or less it moves all at once, on the tick that reaches start.
+	 * @return the channel's end time, to start the next step of a sequence at.
+	 */
+	float_t addTranslation(ObjectRef object, float_t start, float_t duration, const glm::vec3& totalMovement);
+
+	/**
+	 * @brief Rotates the object by the given total rotation, evenly over [start, start + duration].
+	 * With a duration of zero or less it rotates all at once, on the tick that reaches start.
+	 * @return the channel's end time, to start the next step of a sequence at.
+	 */
+	float_t addRotation(ObjectRef object, float_t start, float_t duration, const glm::vec3& totalRotation);
+
+	/**
+	 * @brief The time at which the last channel ends.
+	 */
+	float_t duration() const { return m_duration; }
+
+	/**
+	 * @brief How many channels are scheduled.
+	 */
+	size_t channelCount() const { return m_translations.size() + m_rotations.size(); }
+
+	/**
+	 * @brief Starts the system's clock at zero.
+	 */
+	void start();
+
+	/**
+	 * @brief Advances every channel by the given time interval, in seconds, applying the results
+	 * to the objects in the given store. Channels whose object no longer exists are skipped.
+	 */
+	void tick(float_t dt, ObjectStore& objects);
+};
@@ -1,12 +1,12 @@
 	#include "Animator.h"
 
-void Animator::nextAnimation() {
+void Animator::nextAnimation(ObjectStore& objects) {
 	// Increase the animation index, and start the next animation if there is one.
 	++m_currentIndex;
 
 	if (m_currentIndex < m_animations.size()) {
 		m_currentAnimation = m_animations[m_currentIndex].get();
-		m_currentAnimation->start();
+		m_currentAnimation->start(objects);
 		m_nextTransition = m_nextTransition + m_currentAnimation->duration();
 	}
 	else {
@@ -16,7 +16,7 @@ void Animator::nextAnimation() {
 }
 
 
-void Animator::tick(float_t dt) {
+void Animator::tick(float_t dt, ObjectStore& objects) {
 	// Advance the active animation by the given interval.
 	if (m_currentIndex >= 0) {
 		float_t lastTime = m_currentTime;
@@ -26,29 +26,20 @@ void Animator::tick(float_t dt) {
 		// both the active animation (up to the transition time), and the subsequent animation
 		// (by the amount we exceeded the transition time).
 		if (m_currentTime >= m_nextTransition) {
-			m_currentAnimation->tick(m_nextTransition - lastTime);
+			m_currentAnimation->tick(m_nextTransition - lastTime, objects);
 			float_t overTime = m_currentTime - m_nextTransition;
-			nextAnimation();
+			nextAnimation(objects);
 			if (m_currentAnimation != nullptr) {
-				m_currentAnimation->tick(overTime);
+				m_currentAnimation->tick(overTime, objects);
 			}
-			m_parallelAnimationsStarted = true;
 		}
 		else {
-			m_currentAnimation->tick(dt);
-		}
-	}
-	if (m_parallelAnimationsStarted) {
-		for (auto* animation : m_panimations) {
-			if (animation->currentTime() < animation->duration()) {
-				animation->tick(dt);
-			}
+			m_currentAnimation->tick(dt, objects);
 		}
 	}
 }
 
-void Animator::start() {
+void Animator::start(ObjectStore& objects) {
 	m_currentTime = 0;
-	m_parallelAnimationsStarted = false;
-	nextAnimation();
+	nextAnimation(objects);
 }
@@ -19,8 +19,6 @@ private:
 	 * @brief The sequence of animations to play.
 	 */
 	std::vector<std::unique_ptr<Animation>> m_animations;
-	std::vector<Animation*> m_panimations;
-	bool m_parallelAnimationsStarted = false;
 	/**
 	 * @brief The current (active) animation.
 	 */
@@ -33,7 +31,7 @@ private:
 	/**
 	 * @brief Activate the next animation.
 	 */
-	void nextAnimation();
+	void nextAnimation(ObjectStore& objects);
 
 public:
 	/**
@@ -47,23 +45,22 @@ public:
 	}
 
 	/**
-	 * @brief Add an Animation to the end of the animation sequence.
+	 * @brief Add an Animation to the end of the animation sequence. To play animations at the same
+	 * time, schedule them on a Timeline instead.
 	 */
-	void addAnimation(std::unique_ptr<Animation> animation, bool isParallel = false) {
+	void addAnimation(std::unique_ptr<Animation> animation) {
 		m_animations.emplace_back(std::move(animation));
-		if (isParallel) {
-			m_panimations.push_back(m_animations.back().get());
-		}
 	}
 
 	/**
 	 * @brief Activate the Animator, causing its active animation to receive future tick() calls.
 	 */
-	void start();
+	void start(ObjectStore& objects);
 
 	/**
-	 * @brief Advance the animation sequence by the given time interval, in seconds.
+	 * @brief Advance the animation sequence by the given time interval, in seconds, applying it
+	 * to the objects in the given store.
 	 */
-	void tick(float_t dt);
+	void tick(float_t dt, ObjectStore& objects);
 
 };
\ No newline at end of file
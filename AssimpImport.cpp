@@ -1,4 +1,6 @@
 #include "AssimpImport.h"
+#include "MeshSimplifier.h"
+#include "MeshSplitter.h"
 #include <iostream>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -9,6 +11,26 @@
 
 const size_t FLOATS_PER_VERTEX = 3;
 const size_t VERTICES_PER_FACE = 3;
+// Each mesh gets up to this many levels of detail after its full-detail faces, each with about
+// half the triangles of the one before.
+const size_t LOD_LEVELS = 3;
+// Meshes with fewer triangles than this are cheap enough to always draw in full.
+const size_t MIN_LOD_TRIANGLES = 256;
+// Simplification stops once the surface strays this far, as a fraction of the mesh's size.
+const float_t MAX_LOD_ERROR = 0.05f;
+
+/**
+ * @brief Converts an assimp matrix (row-major) to a glm matrix (column-major).
+ */
+static glm::mat4 toGlmMatrix(const aiMatrix4x4& m) {
+	glm::mat4 result;
+	for (auto i = 0; i < 4; i++) {
+		for (auto j = 0; j < 4; j++) {
+			result[i][j] = m[j][i];
+		}
+	}
+	return result;
+}
 
 std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName, const std::filesystem::path& modelPath,
 	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
@@ -34,10 +56,42 @@ std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, c
 	return textures;
 }
 
-Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
-	std::vector<Vertex3D> vertices;
+/**
+ * @brief The mesh's faces, followed by its simplified levels of detail, which keep the locked
+ * vertices in place. A level that barely reduces the one before it is not worth its memory, so
+ * it ends the list.
+ */
+static std::vector<MeshLevel> buildLevels(const std::vector<Vertex3D>& vertices, std::vector<uint32_t>&& faces,
+	const std::vector<bool>& locked) {
+	size_t triangles = faces.size() / VERTICES_PER_FACE;
+	std::vector<size_t> targets;
+	if (triangles >= MIN_LOD_TRIANGLES) {
+		for (size_t i = 1; i <= LOD_LEVELS; i++) {
+			targets.push_back(triangles >> i);
+		}
+	}
+	BoundingBox bounds;
+	for (auto& v : vertices) {
+		bounds.expand(glm::vec3(v.x, v.y, v.z));
+	}
+	auto simplified = simplifyMesh(vertices, faces, targets, glm::length(bounds.extents()) * 2 * MAX_LOD_ERROR,
+		locked);
+
+	std::vector<MeshLevel> levels;
+	levels.push_back(MeshLevel{ std::move(faces), 0 });
+	for (auto& level : simplified) {
+		if (level.faces.size() * 5 > levels.back().faces.size() * 4) {
+			break;
+		}
+		levels.push_back(std::move(level));
+	}
+	return levels;
+}
 
+/**
+ * @brief Reads the mesh's vertices and triangles.
+ */
+static void readAssimpMesh(const aiMesh* mesh, std::vector<Vertex3D>& vertices, std::vector<uint32_t>& faces) {
 	for (size_t i = 0; i < mesh->mNumVertices; i++) {
 		auto* tex = mesh->mTextureCoords[0];
 		if (tex != nullptr) {
@@ -52,14 +106,66 @@ Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::files
 		}
 	}
 
-	std::vector<uint32_t> faces;
 	faces.reserve(mesh->mNumFaces * VERTICES_PER_FACE);
 	for (size_t i = 0; i < mesh->mNumFaces; i++) {
 		faces.push_back(mesh->mFaces[i].mIndices[0]);
 		faces.push_back(mesh->mFaces[i].mIndices[1]);
 		faces.push_back(mesh->mFaces[i].mIndices[2]);
 	}
+}
+
+/**
+ * @brief Builds a Mesh3D with its levels of detail, and a copy of its triangles if asked. Locked
+ * vertices, such as those on the seams between chunks, are kept by every level.
+ */
+static Mesh3D buildMesh(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
+	std::vector<Texture>&& textures, bool keepTriangles, const std::vector<bool>& locked = {}) {
+	std::shared_ptr<const TriangleBVH> triangles;
+	if (keepTriangles) {
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertices.size());
+		for (auto& v : vertices) {
+			positions.emplace_back(v.x, v.y, v.z);
+		}
+		triangles = std::make_shared<const TriangleBVH>(TriangleBVH::fromIndexed(positions, faces));
+	}
+
+	auto levels = buildLevels(vertices, std::move(faces), locked);
+	auto m = Mesh3D(std::move(vertices), std::move(levels), std::move(textures));
+	m.setTriangles(std::move(triangles));
+	return m;
+}
+
+Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures, bool keepTriangles) {
+	std::vector<Vertex3D> vertices;
+	std::vector<uint32_t> faces;
+	readAssimpMesh(mesh, vertices, faces);
+	return buildMesh(std::move(vertices), std::move(faces), loadMeshTextures(mesh, scene, modelPath, loadedTextures),
+		keepTriangles);
+}
+
+std::vector<Mesh3D> fromAssimpMeshChunks(const aiMesh* mesh, const aiScene* scene,
+	const std::filesystem::path& modelPath, std::unordered_map<std::filesystem::path, Texture>& loadedTextures,
+	bool keepTriangles, const ChunkImportOptions& chunks) {
+	std::vector<Mesh3D> meshes;
+	if (chunks.cellSize <= 0 || mesh->mNumFaces < chunks.minTriangles) {
+		meshes.push_back(fromAssimpMesh(mesh, scene, modelPath, loadedTextures, keepTriangles));
+		return meshes;
+	}
+	std::vector<Vertex3D> vertices;
+	std::vector<uint32_t> faces;
+	readAssimpMesh(mesh, vertices, faces);
+	auto textures = loadMeshTextures(mesh, scene, modelPath, loadedTextures);
+	for (auto& chunk : splitMesh(vertices, faces, chunks.cellSize)) {
+		meshes.push_back(buildMesh(std::move(chunk.vertices), std::move(chunk.faces), std::vector<Texture>(textures),
+			keepTriangles, chunk.locked));
+	}
+	return meshes;
+}
 
+std::vector<Texture> loadMeshTextures(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
 	std::vector<Texture> textures = {};
 	if (mesh->mMaterialIndex >= 0)
 	{
@@ -77,14 +183,13 @@ Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::files
 			aiTextureType_NORMALS, "normalMap", modelPath, loadedTextures);
 		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
 	}
-
-	auto m = Mesh3D(std::move(vertices), std::move(faces), std::move(textures));
-	return m;
+	return textures;
 }
 
 
 
-Object3D assimpLoad(const std::string& path, bool flipTextureCoords) {
+Object3D assimpLoad(const std::string& path, bool flipTextureCoords, bool keepTriangles,
+	const ChunkImportOptions& chunks) {
 	Assimp::Importer importer;
 
 	auto options = aiProcessPreset_TargetRealtime_MaxQuality;
@@ -134,7 +239,12 @@ Object3D assimpLoad(const std::string& path, bool flipTextureCoords) {
 	//auto ret = Object3D(std::make_shared<Mesh3D>(fromAssimpMesh(scene->mMeshes[0], scene, textures)));
 	std::vector<Mesh3D> meshes;
 	std::unordered_map<std::filesystem::path, Texture> loadedTextures;
-	auto ret = processAssimpNode(scene->mRootNode, scene, std::filesystem::path(path), loadedTextures);
+	auto ret = processAssimpNode(scene->mRootNode, scene, std::filesystem::path(path), loadedTextures, keepTriangles,
+		chunks);
+
+	auto stats = ret.getOptimizationStats();
+	std::cout << path << ": " << stats.after.triangles << " triangles, ACMR " << stats.before.acmr() << " -> "
+		<< stats.after.acmr() << ", ATVR " << stats.before.atvr() << " -> " << stats.after.atvr() << std::endl;
 
 	// aiNode -> Object3D. the aiNode's mTransformation -> Object3D.m_baseTransform.
 	// The list of meshes in aiNode -> Model3D.
@@ -143,31 +253,225 @@ Object3D assimpLoad(const std::string& path, bool flipTextureCoords) {
 
 Object3D processAssimpNode(aiNode* node, const aiScene* scene,
 	const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures, bool keepTriangles,
+	const ChunkImportOptions& chunks) {
 
 	// Load the aiNode's meshes.
 	std::vector<Mesh3D> meshes;
 	for (auto i = 0; i < node->mNumMeshes; i++) {
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.emplace_back(fromAssimpMesh(mesh, scene, modelPath, loadedTextures));
+		for (auto& part : fromAssimpMeshChunks(mesh, scene, modelPath, loadedTextures, keepTriangles, chunks)) {
+			meshes.push_back(std::move(part));
+		}
 	}
 
 	std::vector<Texture> textures;
 	for (auto& p : loadedTextures) {
 		textures.push_back(p.second);
 	}
-	glm::mat4 baseTransform;
-	for (auto i = 0; i < 4; i++) {
-		for (auto j = 0; j < 4; j++) {
-			baseTransform[i][j] = node->mTransformation[j][i];
-		}
-	}
+	glm::mat4 baseTransform = toGlmMatrix(node->mTransformation);
 	auto parent = Object3D(std::move(meshes), baseTransform);
 
 	for (auto i = 0; i < node->mNumChildren; i++) {
-		Object3D child = processAssimpNode(node->mChildren[i], scene, modelPath, loadedTextures);
+		Object3D child = processAssimpNode(node->mChildren[i], scene, modelPath, loadedTextures, keepTriangles, chunks);
 		parent.addChild(std::move(child));
 	}
 
 	return parent;
 }
+
+/**
+ * @brief Adds the node and its descendants to the skeleton, parents first, and records which
+ * node owns each mesh.
+ */
+static void addSkeletonNodes(const aiNode* node, int32_t parent, Skeleton& skeleton,
+	std::vector<std::string>& meshNodes) {
+	int32_t index = skeleton.addNode(node->mName.C_Str(), parent, toGlmMatrix(node->mTransformation));
+	for (auto i = 0; i < node->mNumMeshes; i++) {
+		meshNodes[node->mMeshes[i]] = node->mName.C_Str();
+	}
+	for (auto i = 0; i < node->mNumChildren; i++) {
+		addSkeletonNodes(node->mChildren[i], index, skeleton, meshNodes);
+	}
+}
+
+SkinnedMesh3D fromAssimpSkinnedMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
+	const std::string& meshNode, Skeleton& skeleton,
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures) {
+	std::vector<SkinnedVertex3D> vertices;
+	vertices.reserve(mesh->mNumVertices);
+	auto* tex = mesh->mTextureCoords[0];
+	for (size_t i = 0; i < mesh->mNumVertices; i++) {
+		vertices.emplace_back(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z,
+			mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z,
+			tex != nullptr ? tex[i].x : 0, tex != nullptr ? tex[i].y : 0);
+	}
+
+	if (mesh->HasBones()) {
+		for (auto b = 0; b < mesh->mNumBones; b++) {
+			const aiBone* bone = mesh->mBones[b];
+			int32_t index = skeleton.addBone(bone->mName.C_Str(), toGlmMatrix(bone->mOffsetMatrix));
+			if (index < 0) {
+				continue;
+			}
+			for (auto w = 0; w < bone->mNumWeights; w++) {
+				vertices[bone->mWeights[w].mVertexId].addBone(index, bone->mWeights[w].mWeight);
+			}
+		}
+		for (auto& v : vertices) {
+			v.normalizeWeights();
+		}
+	}
+	else {
+		// A rigid part of the model: its node is a bone whose offset is the identity, because the
+		// vertices are already in the node's space.
+		int32_t index = skeleton.addBone(meshNode, glm::mat4(1.0f));
+		if (index >= 0) {
+			for (auto& v : vertices) {
+				v.addBone(index, 1);
+			}
+		}
+	}
+
+	std::vector<uint32_t> faces;
+	faces.reserve(mesh->mNumFaces * VERTICES_PER_FACE);
+	for (size_t i = 0; i < mesh->mNumFaces; i++) {
+		faces.push_back(mesh->mFaces[i].mIndices[0]);
+		faces.push_back(mesh->mFaces[i].mIndices[1]);
+		faces.push_back(mesh->mFaces[i].mIndices[2]);
+	}
+
+	return SkinnedMesh3D(std::move(vertices), std::move(faces), loadMeshTextures(mesh, scene, modelPath, loadedTextures));
+}
+
+SkeletalClip fromAssimpAnimation(const aiAnimation* animation, const Skeleton& skeleton) {
+	// Key times are in ticks; files that do not say how long a tick is use 25 per second.
+	double ticksPerSecond = animation->mTicksPerSecond != 0 ? animation->mTicksPerSecond : 25.0;
+	SkeletalClip clip(animation->mName.C_Str(), static_cast<float_t>(animation->mDuration / ticksPerSecond));
+	for (auto c = 0; c < animation->mNumChannels; c++) {
+		const aiNodeAnim* nodeAnim = animation->mChannels[c];
+		int32_t node = skeleton.findNode(nodeAnim->mNodeName.C_Str());
+		if (node < 0) {
+			continue;
+		}
+		auto& channel = clip.addChannel(node);
+		for (auto k = 0; k < nodeAnim->mNumPositionKeys; k++) {
+			auto& key = nodeAnim->mPositionKeys[k];
+			channel.position.addKey(static_cast<float_t>(key.mTime / ticksPerSecond),
+				glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+		}
+		for (auto k = 0; k < nodeAnim->mNumRotationKeys; k++) {
+			auto& key = nodeAnim->mRotationKeys[k];
+			channel.rotation.addKey(static_cast<float_t>(key.mTime / ticksPerSecond),
+				glm::quat(key.mValue.w, key.mValue.x, key.mValue.y, key.mValue.z));
+		}
+		for (auto k = 0; k < nodeAnim->mNumScalingKeys; k++) {
+			auto& key = nodeAnim->mScalingKeys[k];
+			channel.scale.addKey(static_cast<float_t>(key.mTime / ticksPerSecond),
+				glm::vec3(key.mValue.x, key.mValue.y, key.mValue.z));
+		}
+	}
+	return clip;
+}
+
+SkinnedModel assimpLoadSkinned(const std::string& path, bool flipTextureCoords) {
+	Assimp::Importer importer;
+
+	auto options = aiProcessPreset_TargetRealtime_MaxQuality;
+	if (flipTextureCoords) {
+		options |= aiProcess_FlipUVs;
+	}
+	const aiScene* scene = importer.ReadFile(path, options);
+	if (nullptr == scene) {
+		throw std::runtime_error("Error loading assimp file ");
+	}
+
+	Skeleton skeleton;
+	std::vector<std::string> meshNodes(scene->mNumMeshes);
+	addSkeletonNodes(scene->mRootNode, -1, skeleton, meshNodes);
+	skeleton.setGlobalInverse(glm::inverse(toGlmMatrix(scene->mRootNode->mTransformation)));
+
+	std::filesystem::path modelPath(path);
+	std::unordered_map<std::filesystem::path, Texture> loadedTextures;
+	std::vector<SkinnedMesh3D> meshes;
+	for (auto i = 0; i < scene->mNumMeshes; i++) {
+		meshes.emplace_back(fromAssimpSkinnedMesh(scene->mMeshes[i], scene, modelPath, meshNodes[i], skeleton,
+			loadedTextures));
+	}
+
+	std::vector<SkeletalClip> clips;
+	for (auto i = 0; i < scene->mNumAnimations; i++) {
+		clips.push_back(fromAssimpAnimation(scene->mAnimations[i], skeleton));
+	}
+
+	return SkinnedModel(std::move(meshes), std::move(skeleton), std::move(clips));
+}
+
+/**
+ * @brief Appends the triangles of the node and its descendants, transformed to world space.
+ * A selected node selects all of its meshes and descendants.
+ */
+static void addCollisionTriangles(const aiNode* node, const aiScene* scene, const glm::mat4& parentTransform,
+	const std::vector<std::string>& names, bool selected, std::vector<CollisionTriangle>& triangles) {
+	glm::mat4 transform = parentTransform * toGlmMatrix(node->mTransformation);
+	auto named = [&names](const aiString& name) {
+		return std::find(names.begin(), names.end(), name.C_Str()) != names.end();
+	};
+	selected = selected || named(node->mName);
+	for (auto i = 0; i < node->mNumMeshes; i++) {
+		const aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+		if (!selected && !named(mesh->mName)) {
+			continue;
+		}
+		auto vertex = [mesh, &transform](uint32_t index) {
+			const aiVector3D& v = mesh->mVertices[index];
+			return glm::vec3(transform * glm::vec4(v.x, v.y, v.z, 1));
+		};
+		for (auto f = 0; f < mesh->mNumFaces; f++) {
+			const aiFace& face = mesh->mFaces[f];
+			// Points and lines left by triangulation have no surface to collide with.
+			if (face.mNumIndices == 3) {
+				triangles.push_back(CollisionTriangle{ vertex(face.mIndices[0]), vertex(face.mIndices[1]),
+					vertex(face.mIndices[2]) });
+			}
+		}
+	}
+	for (auto i = 0; i < node->mNumChildren; i++) {
+		addCollisionTriangles(node->mChildren[i], scene, transform, names, selected, triangles);
+	}
+}
+
+TriangleBVH assimpLoadCollision(const std::string& path, const CollisionImportOptions& options) {
+	// The baked tree is only good for the same selection of meshes, in any order.
+	std::vector<std::string> names = options.meshNames;
+	std::sort(names.begin(), names.end());
+	std::string key;
+	for (auto& name : names) {
+		key += name + "\n";
+	}
+
+	const auto& baked = options.bakedPath;
+	std::error_code error;
+	std::string bakedKey;
+	if (!baked.empty() && std::filesystem::exists(baked, error)
+		&& std::filesystem::last_write_time(baked, error) >= std::filesystem::last_write_time(path, error)
+		&& !error && TriangleBVH::readKey(baked, bakedKey) && bakedKey == key) {
+		return TriangleBVH::load(baked);
+	}
+
+	Assimp::Importer importer;
+	// Only positions matter, so skip the normal, tangent and UV processing of the render import.
+	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+	if (nullptr == scene) {
+		throw std::runtime_error("Error loading assimp file ");
+	}
+
+	std::vector<CollisionTriangle> triangles;
+	addCollisionTriangles(scene->mRootNode, scene, glm::mat4(1), options.meshNames, options.meshNames.empty(),
+		triangles);
+	TriangleBVH bvh(std::move(triangles));
+	if (!baked.empty()) {
+		bvh.save(baked, key);
+	}
+	return bvh;
+}
@@ -1,15 +1,70 @@
 #pragma once
 #include "Mesh3D.h"
 #include "Object3D.h"
+#include "SkinnedMesh.h"
+#include "TriangleBVH.h"
 #include <unordered_map>
 #include <assimp/scene.h>
 
+/**
+ * @brief How assimpLoad splits large meshes into spatial chunks, so that culling, occlusion and
+ * levels of detail can treat each part of a big model on its own.
+ */
+struct ChunkImportOptions {
+	// The edge length of the grid cubes meshes are split on. Zero keeps every mesh whole.
+	float_t cellSize = 0;
+	// Meshes with fewer triangles than this are kept whole.
+	size_t minTriangles = 512;
+};
+
 Mesh3D fromAssimpMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
-Object3D assimpLoad(const std::string& path, bool flipTextureCoords);
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures, bool keepTriangles = false);
+/**
+ * @brief Loads a mesh as one Mesh3D per chunk it splits into, each with the mesh's material.
+ */
+std::vector<Mesh3D> fromAssimpMeshChunks(const aiMesh* mesh, const aiScene* scene,
+	const std::filesystem::path& modelPath, std::unordered_map<std::filesystem::path, Texture>& loadedTextures,
+	bool keepTriangles, const ChunkImportOptions& chunks);
+/**
+ * @brief Loads a model as an object hierarchy. With keepTriangles, each mesh also keeps a copy
+ * of its triangles for exact ray tests. Large meshes are split into chunks as the options say;
+ * each chunk is a mesh of the node the whole mesh belonged to.
+ */
+Object3D assimpLoad(const std::string& path, bool flipTextureCoords, bool keepTriangles = false,
+	const ChunkImportOptions& chunks = {});
 Object3D processAssimpNode(aiNode* node, const aiScene* scene,
 	const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& textures);
+	std::unordered_map<std::filesystem::path, Texture>& textures, bool keepTriangles = false,
+	const ChunkImportOptions& chunks = {});
 std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string& typeName,
 	const std::filesystem::path& modelPath,
-	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
\ No newline at end of file
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
+std::vector<Texture> loadMeshTextures(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
+
+/**
+ * @brief Loads a model as a single skinned model: its bones and vertex weights, its node
+ * hierarchy as a skeleton, and its animations as clips. Meshes without bones follow their node.
+ */
+SkinnedModel assimpLoadSkinned(const std::string& path, bool flipTextureCoords);
+SkinnedMesh3D fromAssimpSkinnedMesh(const aiMesh* mesh, const aiScene* scene, const std::filesystem::path& modelPath,
+	const std::string& meshNode, Skeleton& skeleton,
+	std::unordered_map<std::filesystem::path, Texture>& loadedTextures);
+SkeletalClip fromAssimpAnimation(const aiAnimation* animation, const Skeleton& skeleton);
+
+/**
+ * @brief Chooses the geometry assimpLoadCollision reads, and where it caches the built tree.
+ */
+struct CollisionImportOptions {
+	// Only meshes, or nodes, with these names are collidable. Empty means everything is.
+	std::vector<std::string> meshNames;
+	// If set, the built tree is saved here, and loaded instead of rebuilding while it is newer
+	// than the model and was built from the same mesh names.
+	std::filesystem::path bakedPath;
+};
+
+/**
+ * @brief Loads a model's triangles in world space, ignoring materials and texture coordinates,
+ * and builds a collision hierarchy over them.
+ */
+TriangleBVH assimpLoadCollision(const std::string& path, const CollisionImportOptions& options = {});
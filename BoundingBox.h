@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <glm/glm.hpp>
+
+/**
+ * @brief An axis-aligned bounding box. A default-constructed box is empty (min > max) and
+ * becomes valid once a point is added to it.
+ */
+struct BoundingBox {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	BoundingBox() : min(std::numeric_limits<float_t>::max()), max(-std::numeric_limits<float_t>::max()) {}
+	BoundingBox(const glm::vec3& minCorner, const glm::vec3& maxCorner) : min(minCorner), max(maxCorner) {}
+
+	bool isEmpty() const {
+		return min.x > max.x || min.y > max.y || min.z > max.z;
+	}
+
+	glm::vec3 center() const {
+		return (min + max) * 0.5f;
+	}
+
+	glm::vec3 extents() const {
+		return (max - min) * 0.5f;
+	}
+
+	/**
+	 * @brief Grows the box to contain the given point.
+	 */
+	void expand(const glm::vec3& point) {
+		min = glm::min(min, point);
+		max = glm::max(max, point);
+	}
+
+	/**
+	 * @brief Grows the box to contain the given box.
+	 */
+	void expand(const BoundingBox& other) {
+		if (!other.isEmpty()) {
+			expand(other.min);
+			expand(other.max);
+		}
+	}
+
+	/**
+	 * @brief The box containing this box after it is transformed by the given matrix.
+	 */
+	BoundingBox transformed(const glm::mat4& m) const {
+		if (isEmpty()) {
+			return *this;
+		}
+		// Transform the center, then project the extents onto each world axis (Arvo's method).
+		glm::vec3 c(m * glm::vec4(center(), 1.0f));
+		glm::vec3 e = extents();
+		glm::vec3 worldExtents(
+			std::abs(m[0][0]) * e.x + std::abs(m[1][0]) * e.y + std::abs(m[2][0]) * e.z,
+			std::abs(m[0][1]) * e.x + std::abs(m[1][1]) * e.y + std::abs(m[2][1]) * e.z,
+			std::abs(m[0][2]) * e.x + std::abs(m[1][2]) * e.y + std::abs(m[2][2]) * e.z);
+		return BoundingBox(c - worldExtents, c + worldExtents);
+	}
+
+	/**
+	 * @brief The squared distance from the given point to the nearest point in the box;
+	 * 0 if the point is inside.
+	 */
+	float_t distanceSquared(const glm::vec3& point) const {
+		glm::vec3 nearest = glm::clamp(point, min, max);
+		glm::vec3 d = point - nearest;
+		return glm::dot(d, d);
+	}
+
+	bool contains(const glm::vec3& point) const {
+		return point.x >= min.x && point.x <= max.x
+			&& point.y >= min.y && point.y <= max.y
+			&& point.z >= min.z && point.z <= max.z;
+	}
+
+	bool overlaps(const BoundingBox& other) const {
+		return min.x <= other.max.x && max.x >= other.min.x
+			&& min.y <= other.max.y && max.y >= other.min.y
+			&& min.z <= other.max.z && max.z >= other.min.z;
+	}
+};
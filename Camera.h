@@ -61,33 +61,42 @@ public:
 	glm::mat4 GetViewMatrix() {
 		return glm::lookAt(Pos, Pos + Front, Up);
 	}
-	void ProcessMovement(Camera_Movement direction, bool FPS) {
+	/**
+	 * @brief How far one movement input moves the camera. In FPS mode the camera walks: forward
+	 * and backward stay level, and there is no moving up or down.
+	 */
+	glm::vec3 MovementOffset(Camera_Movement direction, bool FPS) const {
 		float velocity = Movespeed;
+		glm::vec3 offset(0.0f);
 		//FPS
 		if (FPS) {
 			glm::vec3 moveDirection = Front;
 			moveDirection.y = 0;
 			moveDirection = glm::normalize(moveDirection);
 			if (direction == FORWARD)
-				Pos += moveDirection * velocity;
+				offset += moveDirection * velocity;
 			if (direction == BACKWARD)
-				Pos -= moveDirection * velocity;
+				offset -= moveDirection * velocity;
 		}
 		if (!FPS) {
 			if (direction == FORWARD)
-				Pos += Front * velocity;
+				offset += Front * velocity;
 			if (direction == BACKWARD)
-				Pos -= Front * velocity;
+				offset -= Front * velocity;
 			if (direction == SPACE)
-				Pos += Up * velocity;
+				offset += Up * velocity;
 			if (direction == CTRL)
-				Pos -= Up * velocity;
+				offset -= Up * velocity;
 		}
 		
 		if (direction == LEFT)
-			Pos -= Right * velocity;
+			offset -= Right * velocity;
 		if (direction == RIGHT)
-			Pos += Right * velocity;
+			offset += Right * velocity;
+		return offset;
+	}
+	void ProcessMovement(Camera_Movement direction, bool FPS) {
+		Pos += MovementOffset(direction, FPS);
 	}
 
 	void ProcessAngle(Camera_Angle angle) {
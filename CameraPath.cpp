@@ -0,0 +1,55 @@
+#include "CameraPath.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+CameraPath::CameraPath()
+	: m_position(Interpolation::Cubic), m_front(Interpolation::Cubic), m_up(Interpolation::Cubic) {
+}
+
+CameraPath CameraPath::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("Could not open camera path " + path);
+	}
+
+	CameraPath cameraPath;
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(file, line)) {
+		lineNumber++;
+		std::istringstream fields(line);
+		std::string first;
+		if (!(fields >> first) || first[0] == '#') {
+			continue;
+		}
+		std::istringstream timeField(first);
+		float_t time;
+		glm::vec3 position, front, up;
+		if (!(timeField >> time) || !(fields >> position.x >> position.y >> position.z >> front.x >> front.y >> front.z
+			>> up.x >> up.y >> up.z)) {
+			throw std::runtime_error("Malformed key on line " + std::to_string(lineNumber) + " of " + path);
+		}
+		cameraPath.addKey(time, position, front, up);
+	}
+	if (cameraPath.m_position.empty()) {
+		throw std::runtime_error("Camera path " + path + " has no keys");
+	}
+	return cameraPath;
+}
+
+void CameraPath::addKey(float_t time, const glm::vec3& position, const glm::vec3& front, const glm::vec3& up) {
+	m_position.addKey(time, position);
+	m_front.addKey(time, front);
+	m_up.addKey(time, up);
+}
+
+float_t CameraPath::duration() const {
+	return m_position.duration();
+}
+
+void CameraPath::apply(Camera& camera, float_t time) const {
+	camera.Pos = m_position.sample(time);
+	camera.Front = m_front.sample(time);
+	camera.Up = m_up.sample(time);
+}
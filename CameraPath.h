@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include "Camera.h"
+#include "KeyframeTrack.h"
+
+/**
+ * @brief A scripted camera flight: position, look direction and up vector keyed over time and
+ * joined by Catmull-Rom splines. Sampling is by absolute time, so a cutscene plays the same at
+ * any frame rate, and the keys live in a text file so it can be edited without recompiling.
+ */
+class CameraPath {
+private:
+	KeyframeTrack<glm::vec3> m_position;
+	KeyframeTrack<glm::vec3> m_front;
+	KeyframeTrack<glm::vec3> m_up;
+
+public:
+	CameraPath();
+
+	/**
+	 * @brief Loads a path from a text file with one key per line:
+	 * time px py pz fx fy fz ux uy uz. Blank lines and lines starting with # are ignored.
+	 */
+	static CameraPath load(const std::string& path);
+
+	/**
+	 * @brief Adds a key. Two keys at the same time make a cut.
+	 */
+	void addKey(float_t time, const glm::vec3& position, const glm::vec3& front, const glm::vec3& up);
+
+	/**
+	 * @brief The time of the last key.
+	 */
+	float_t duration() const;
+
+	/**
+	 * @brief Places the camera where the path has it at the given time, in seconds.
+	 */
+	void apply(Camera& camera, float_t time) const;
+};
@@ -0,0 +1,130 @@
+#include "CharacterController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// How far the capsule stays from the surfaces it touches, so each sweep starts clear of them.
+	const float_t SKIN = 1e-3f;
+	// Surfaces whose normal points at least this far up can be stood on; about 45 degrees.
+	const float_t MIN_GROUND_NORMAL = 0.7f;
+}
+
+CharacterController::CharacterController(PhysicsWorld& world, float_t radius, float_t height, float_t eyeHeight,
+	float_t stepHeight, float_t gravity)
+	: m_world(world), m_radius(radius), m_height(std::max(height, 2 * radius)), m_eyeHeight(eyeHeight),
+	m_stepHeight(stepHeight), m_gravity(gravity), m_fallSpeed(0), m_grounded(false) {
+	float_t axis = m_height - 2 * m_radius;
+	m_spheres = static_cast<uint32_t>(std::ceil(axis / m_radius)) + 1;
+	m_sphereSpacing = m_spheres > 1 ? axis / (m_spheres - 1) : 0;
+}
+
+bool CharacterController::grounded() const {
+	return m_grounded;
+}
+
+glm::vec3 CharacterController::sphereCenter(const glm::vec3& feet, uint32_t i) const {
+	return feet + glm::vec3(0, m_radius + i * m_sphereSpacing, 0);
+}
+
+bool CharacterController::sweep(const glm::vec3& feet, const glm::vec3& motion, float_t& fraction,
+	glm::vec3& normal) const {
+	bool hit = false;
+	fraction = 1;
+	for (uint32_t i = 0; i < m_spheres; i++) {
+		glm::vec3 center = sphereCenter(feet, i);
+		float_t t;
+		glm::vec3 n;
+		for (auto& box : m_boxes) {
+			if (sweepSphereBox(center, motion, m_radius, box, t, n) && t < fraction) {
+				fraction = t;
+				normal = n;
+				hit = true;
+			}
+		}
+		for (auto& triangle : m_triangles) {
+			if (sweepSphereTriangle(center, motion, m_radius, triangle, t, n) && t < fraction) {
+				fraction = t;
+				normal = n;
+				hit = true;
+			}
+		}
+	}
+	return hit;
+}
+
+glm::vec3 CharacterController::slide(glm::vec3 feet, glm::vec3 motion, bool stopOnGround, bool& landed) const {
+	landed = false;
+	for (uint32_t i = 0; i < MAX_SLIDES && glm::dot(motion, motion) > 1e-12f; i++) {
+		float_t fraction;
+		glm::vec3 normal;
+		if (!sweep(feet, motion, fraction, normal)) {
+			return feet + motion;
+		}
+		feet += motion * fraction + normal * SKIN;
+		if (stopOnGround && normal.y >= MIN_GROUND_NORMAL) {
+			landed = true;
+			return feet;
+		}
+		// Keep the part of the remaining motion along the surface.
+		motion *= 1 - fraction;
+		motion -= normal * glm::dot(motion, normal);
+	}
+	return feet;
+}
+
+glm::vec3 CharacterController::depenetrate(glm::vec3 feet) const {
+	for (uint32_t i = 0; i < m_spheres; i++) {
+		auto pushOut = [&](const glm::vec3& closest) {
+			glm::vec3 offset = sphereCenter(feet, i) - closest;
+			float_t distance2 = glm::dot(offset, offset);
+			if (distance2 >= m_radius * m_radius) {
+				return;
+			}
+			float_t distance = std::sqrt(distance2);
+			// A center exactly on the surface has no direction out; stepping up is the best guess.
+			glm::vec3 out = distance > 0 ? offset / distance : glm::vec3(0, 1, 0);
+			feet += out * (m_radius - distance + SKIN);
+		};
+		for (auto& box : m_boxes) {
+			pushOut(glm::clamp(sphereCenter(feet, i), box.min, box.max));
+		}
+		for (auto& triangle : m_triangles) {
+			pushOut(closestPointOnTriangle(sphereCenter(feet, i), triangle));
+		}
+	}
+	return feet;
+}
+
+void CharacterController::move(Camera& camera, const glm::vec3& walk, float_t dt) {
+	glm::vec3 feet = camera.Pos - glm::vec3(0, m_eyeHeight, 0);
+	glm::vec3 horizontal(walk.x, 0, walk.z);
+	m_fallSpeed += m_gravity * dt;
+	float_t fall = m_fallSpeed * dt;
+	// Only a capsule standing on something can step up onto something else.
+	float_t rise = m_grounded ? m_stepHeight : 0;
+
+	// One broadphase query covers every sweep below.
+	float_t reach = std::sqrt(glm::dot(horizontal, horizontal)) + m_radius + SKIN;
+	BoundingBox region(feet - glm::vec3(reach, fall + SKIN, reach),
+		feet + glm::vec3(reach, m_height + rise + SKIN, reach));
+	m_boxes.clear();
+	m_triangles.clear();
+	m_world.queryStatic(region, m_boxes, m_triangles);
+
+	// Step up, walk, then come back down by as much as was stepped up plus the fall; on level
+	// ground that returns the capsule to where it started, and a ledge lower than the step
+	// leaves it standing on top.
+	bool landed;
+	feet = depenetrate(feet);
+	float_t start = feet.y;
+	feet = slide(feet, glm::vec3(0, rise, 0), false, landed);
+	float_t raised = feet.y - start;
+	feet = slide(feet, horizontal, false, landed);
+	feet = slide(feet, glm::vec3(0, -(raised + fall), 0), true, landed);
+
+	m_grounded = landed;
+	if (landed) {
+		m_fallSpeed = 0;
+	}
+	camera.Pos = feet + glm::vec3(0, m_eyeHeight, 0);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Camera.h"
+#include "Collision.h"
+#include "PhysicsWorld.h"
+
+/**
+ * @brief Walks a camera through the static geometry of a PhysicsWorld as an upright capsule,
+ * the way a player walks: it slides along walls, steps up ledges lower than its step height,
+ * and falls under gravity until it stands on something.
+ *
+ * The controller is kinematic: it moves exactly as asked unless geometry is in the way, and
+ * pushes nothing. The capsule is swept as spheres stacked along its axis, no further apart than
+ * the radius. Each move makes one broadphase query for the geometry near the whole move, and
+ * then runs every sweep against that list.
+ */
+class CharacterController {
+private:
+	PhysicsWorld& m_world;
+	float_t m_radius;
+	float_t m_height;
+	float_t m_eyeHeight;
+	float_t m_stepHeight;
+	float_t m_gravity;
+	uint32_t m_spheres;
+	float_t m_sphereSpacing;
+
+	// Downward speed, which grows while airborne.
+	float_t m_fallSpeed;
+	bool m_grounded;
+
+	// The static geometry near the current move.
+	std::vector<BoundingBox> m_boxes;
+	std::vector<CollisionTriangle> m_triangles;
+
+	static const uint32_t MAX_SLIDES = 4;
+
+	/**
+	 * @brief The center of the i-th sphere of the capsule standing at feet, counting upwards.
+	 */
+	glm::vec3 sphereCenter(const glm::vec3& feet, uint32_t i) const;
+
+	/**
+	 * @brief Finds the first surface the capsule touches moving from feet by motion.
+	 */
+	bool sweep(const glm::vec3& feet, const glm::vec3& motion, float_t& fraction, glm::vec3& normal) const;
+
+	/**
+	 * @brief Moves the capsule by motion, sliding along each surface it meets, up to MAX_SLIDES
+	 * surfaces. With stopOnGround, it stops instead on the first surface flat enough to stand on.
+	 * @return the capsule's new feet position.
+	 */
+	glm::vec3 slide(glm::vec3 feet, glm::vec3 motion, bool stopOnGround, bool& landed) const;
+
+	/**
+	 * @brief Pushes the capsule out of any geometry it overlaps.
+	 */
+	glm::vec3 depenetrate(glm::vec3 feet) const;
+
+public:
+	/**
+	 * @brief Constructs a controller for a capsule of the given radius and height, whose camera
+	 * sits eyeHeight above its feet.
+	 * @param gravity the falling acceleration, in units per second squared.
+	 */
+	CharacterController(PhysicsWorld& world, float_t radius, float_t height, float_t eyeHeight, float_t stepHeight,
+		float_t gravity);
+
+	/**
+	 * @brief Moves the camera by the walk displacement for this frame, plus any fall over dt
+	 * seconds, as far as the level allows.
+	 */
+	void move(Camera& camera, const glm::vec3& walk, float_t dt);
+
+	/**
+	 * @brief Whether the capsule stood on walkable ground at the end of the last move.
+	 */
+	bool grounded() const;
+};
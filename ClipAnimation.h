@@ -0,0 +1,28 @@
+#pragma once
+#include "Object3D.h"
+#include "Animation.h"
+#include "AnimationClip.h"
+
+/**
+ * @brief Plays a keyframed AnimationClip on an object. Unlike the incremental animations, each
+ * tick poses the object from the clip at the animation's absolute time, so the result does not
+ * drift with frame timing.
+ */
+class ClipAnimation : public Animation {
+private:
+	AnimationClip m_clip;
+
+	/**
+	 * @brief Samples the clip at the current time.
+	 */
+	void applyAnimation(float_t dt) override {
+		m_clip.apply(object(), currentTime());
+	}
+
+public:
+	/**
+	 * @brief Constructs an animation that plays the whole clip once.
+	 */
+	ClipAnimation(ObjectRef object, AnimationClip clip) :
+		Animation(std::move(object), clip.duration()), m_clip(std::move(clip)) {}
+};
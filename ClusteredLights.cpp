@@ -0,0 +1,278 @@
+#include "ClusteredLights.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	/**
+	 * @brief The distance at which a light of the given colours and attenuation falls below
+	 * ClusteredLights::CUTOFF_INTENSITY.
+	 */
+	float_t attenuationRadius(const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+		float_t constant, float_t linear, float_t quadratic) {
+		float_t intensity = std::max({
+			diffuse.x, diffuse.y, diffuse.z,
+			specular.x, specular.y, specular.z,
+			ambient.x, ambient.y, ambient.z });
+		// Solve constant + linear * d + quadratic * d^2 = intensity / cutoff for d.
+		float_t target = intensity / ClusteredLights::CUTOFF_INTENSITY;
+		if (target <= constant) {
+			return 0;
+		}
+		if (quadratic > 0) {
+			float_t discriminant = linear * linear - 4 * quadratic * (constant - target);
+			return (-linear + std::sqrt(discriminant)) / (2 * quadratic);
+		}
+		if (linear > 0) {
+			return (target - constant) / linear;
+		}
+		// No falloff: the light reaches everything.
+		return std::numeric_limits<float_t>::max();
+	}
+}
+
+ClusteredLights::ClusteredLights()
+	: m_grid(CLUSTER_COUNT * 2), m_near(0.1f), m_far(100.0f) {
+	// Each data buffer is exposed to the shader through a buffer texture of the matching format.
+	glGenBuffers(1, &m_lightBuffer);
+	glGenBuffers(1, &m_gridBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+	glGenTextures(1, &m_lightTexture);
+	glGenTextures(1, &m_gridTexture);
+	glGenTextures(1, &m_indexTexture);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_lightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4) * LIGHT_TEXELS, nullptr, GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_lightBuffer);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_grid.size() * sizeof(uint32_t), m_grid.data(), GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, m_gridTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_gridBuffer);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, sizeof(uint32_t), nullptr, GL_STREAM_DRAW);
+	glBindTexture(GL_TEXTURE_BUFFER, m_indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, m_indexBuffer);
+
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+ClusteredLights::~ClusteredLights() {
+	uint32_t textures[] = { m_lightTexture, m_gridTexture, m_indexTexture };
+	uint32_t buffers[] = { m_lightBuffer, m_gridBuffer, m_indexBuffer };
+	glDeleteTextures(3, textures);
+	glDeleteBuffers(3, buffers);
+}
+
+float_t ClusteredLights::lightRadius(const PointLightData& light) {
+	return attenuationRadius(light.ambient, light.diffuse, light.specular, light.constant, light.linear,
+		light.quadratic);
+}
+
+float_t ClusteredLights::lightRadius(const SpotLightData& light) {
+	return attenuationRadius(light.ambient, light.diffuse, light.specular, light.constant, light.linear,
+		light.quadratic);
+}
+
+void ClusteredLights::spotBounds(const SpotLightData& light, glm::vec3& center, float_t& radius) {
+	float_t range = lightRadius(light);
+	float_t cosine = light.outerCutOff;
+	float_t length = glm::length(light.direction);
+	if (range == std::numeric_limits<float_t>::max() || cosine <= 0 || length == 0) {
+		// A cone wider than a hemisphere is bounded no tighter than its whole sphere.
+		center = light.position;
+		radius = range;
+		return;
+	}
+	glm::vec3 axis = light.direction * (1 / length);
+	if (cosine < std::sqrt(0.5f)) {
+		// Wider than 90 degrees across: the circle at the cone's rim bounds it.
+		center = light.position + axis * (range * cosine);
+		radius = range * std::sqrt(1 - cosine * cosine);
+	}
+	else {
+		// Narrower: the sphere through the apex and the rim circle.
+		radius = range / (2 * cosine);
+		center = light.position + axis * radius;
+	}
+}
+
+void ClusteredLights::clear() {
+	m_lights.clear();
+	m_spotLights.clear();
+}
+
+void ClusteredLights::addLight(const PointLightData& light) {
+	m_lights.push_back(light);
+}
+
+void ClusteredLights::addLight(const SpotLightData& light) {
+	m_spotLights.push_back(light);
+}
+
+size_t ClusteredLights::lightCount() const {
+	return m_lights.size() + m_spotLights.size();
+}
+
+uint32_t ClusteredLights::sliceOf(float_t depth) const {
+	float_t slice = std::log(depth / m_near) / std::log(m_far / m_near) * SLICES;
+	return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float_t>(SLICES - 1)));
+}
+
+bool ClusteredLights::clusterRange(const glm::vec3& viewPosition, float_t radius, const glm::mat4& projection,
+	glm::uvec3& minCluster, glm::uvec3& maxCluster) const {
+	// View space looks down -z, so depth increases as z decreases.
+	float_t nearDepth = -viewPosition.z - radius;
+	float_t farDepth = -viewPosition.z + radius;
+	if (farDepth < m_near || nearDepth > m_far) {
+		return false;
+	}
+	minCluster.z = sliceOf(std::max(nearDepth, m_near));
+	maxCluster.z = sliceOf(std::min(farDepth, m_far));
+
+	// Project the corners of the sphere's bounding box. Corners behind the near plane are pulled
+	// onto it, which still bounds the visible part of the sphere.
+	glm::vec2 ndcMin(std::numeric_limits<float_t>::max());
+	glm::vec2 ndcMax(-std::numeric_limits<float_t>::max());
+	for (int32_t corner = 0; corner < 8; corner++) {
+		glm::vec3 p(
+			viewPosition.x + ((corner & 1) ? radius : -radius),
+			viewPosition.y + ((corner & 2) ? radius : -radius),
+			std::min(viewPosition.z + ((corner & 4) ? radius : -radius), -m_near));
+		glm::vec4 clip = projection * glm::vec4(p, 1.0f);
+		glm::vec2 ndc(clip.x / clip.w, clip.y / clip.w);
+		ndcMin.x = std::min(ndcMin.x, ndc.x);
+		ndcMin.y = std::min(ndcMin.y, ndc.y);
+		ndcMax.x = std::max(ndcMax.x, ndc.x);
+		ndcMax.y = std::max(ndcMax.y, ndc.y);
+	}
+	if (ndcMax.x < -1 || ndcMax.y < -1 || ndcMin.x > 1 || ndcMin.y > 1) {
+		return false;
+	}
+
+	auto tile = [](float_t ndc, uint32_t tiles) {
+		float_t t = (ndc * 0.5f + 0.5f) * tiles;
+		return static_cast<uint32_t>(std::clamp(t, 0.0f, static_cast<float_t>(tiles - 1)));
+	};
+	minCluster.x = tile(ndcMin.x, TILES_X);
+	minCluster.y = tile(ndcMin.y, TILES_Y);
+	maxCluster.x = tile(ndcMax.x, TILES_X);
+	maxCluster.y = tile(ndcMax.y, TILES_Y);
+	return true;
+}
+
+void ClusteredLights::binLight(size_t index, const glm::vec3& center, float_t radius, const glm::mat4& view,
+	const glm::mat4& projection) {
+	glm::vec3 viewPosition(view * glm::vec4(center, 1.0f));
+	m_lightVisible[index] = clusterRange(viewPosition, radius, projection, m_lightMin[index], m_lightMax[index]);
+	if (!m_lightVisible[index]) {
+		return;
+	}
+	for (uint32_t z = m_lightMin[index].z; z <= m_lightMax[index].z; z++) {
+		for (uint32_t y = m_lightMin[index].y; y <= m_lightMax[index].y; y++) {
+			for (uint32_t x = m_lightMin[index].x; x <= m_lightMax[index].x; x++) {
+				m_grid[2 * (x + TILES_X * (y + TILES_Y * z)) + 1]++;
+			}
+		}
+	}
+}
+
+void ClusteredLights::update(const glm::mat4& view, const glm::mat4& projection, float_t zNear, float_t zFar) {
+	m_near = zNear;
+	m_far = zFar;
+
+	// Pack each light into LIGHT_TEXELS RGBA texels, matching the layout read by lights.glsl:
+	// point lights first, then spot lights, which also carry their cutoffs and direction.
+	size_t count = lightCount();
+	m_lightTexels.clear();
+	m_lightTexels.reserve(count * LIGHT_TEXELS);
+	m_lightMin.resize(count);
+	m_lightMax.resize(count);
+	m_lightVisible.resize(count);
+
+	// First pass: find each light's cluster range and count the lights in every cluster.
+	std::fill(m_grid.begin(), m_grid.end(), 0);
+	for (size_t i = 0; i < m_lights.size(); i++) {
+		auto& light = m_lights[i];
+		float_t radius = lightRadius(light);
+		m_lightTexels.emplace_back(light.position, light.constant);
+		m_lightTexels.emplace_back(light.ambient, light.linear);
+		m_lightTexels.emplace_back(light.diffuse, light.quadratic);
+		m_lightTexels.emplace_back(light.specular, radius);
+		m_lightTexels.emplace_back(0.0f);
+		binLight(i, light.position, radius, view, projection);
+	}
+	for (size_t i = 0; i < m_spotLights.size(); i++) {
+		auto& light = m_spotLights[i];
+		m_lightTexels.emplace_back(light.position, light.constant);
+		m_lightTexels.emplace_back(light.ambient, light.linear);
+		m_lightTexels.emplace_back(light.diffuse, light.quadratic);
+		m_lightTexels.emplace_back(light.specular, light.cutOff);
+		m_lightTexels.emplace_back(light.direction, light.outerCutOff);
+		glm::vec3 center;
+		float_t radius;
+		spotBounds(light, center, radius);
+		binLight(m_lights.size() + i, center, radius, view, projection);
+	}
+
+	// Prefix sum the counts into offsets, then reset the counts to use them as write cursors.
+	uint32_t total = 0;
+	for (uint32_t c = 0; c < CLUSTER_COUNT; c++) {
+		m_grid[2 * c] = total;
+		total += m_grid[2 * c + 1];
+		m_grid[2 * c + 1] = 0;
+	}
+
+	// Second pass: scatter light indices into each cluster's slice of the index list.
+	m_indices.resize(std::max<uint32_t>(total, 1));
+	for (size_t i = 0; i < count; i++) {
+		if (!m_lightVisible[i]) {
+			continue;
+		}
+		for (uint32_t z = m_lightMin[i].z; z <= m_lightMax[i].z; z++) {
+			for (uint32_t y = m_lightMin[i].y; y <= m_lightMax[i].y; y++) {
+				for (uint32_t x = m_lightMin[i].x; x <= m_lightMax[i].x; x++) {
+					uint32_t c = x + TILES_X * (y + TILES_Y * z);
+					m_indices[m_grid[2 * c] + m_grid[2 * c + 1]++] = static_cast<uint32_t>(i);
+				}
+			}
+		}
+	}
+
+	if (m_lightTexels.empty()) {
+		m_lightTexels.resize(LIGHT_TEXELS, glm::vec4(0));
+	}
+
+	// Orphan and refill each buffer; the shader sees the new contents through its buffer texture.
+	glBindBuffer(GL_TEXTURE_BUFFER, m_lightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_lightTexels.size() * sizeof(glm::vec4), m_lightTexels.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_gridBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_grid.size() * sizeof(uint32_t), m_grid.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_indices.size() * sizeof(uint32_t), m_indices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLights::bind(ShaderProgram& program, uint32_t screenWidth, uint32_t screenHeight,
+	int32_t firstUnit) const {
+	program.activate();
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_lightTexture);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(GL_TEXTURE_BUFFER, m_gridTexture);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+	glBindTexture(GL_TEXTURE_BUFFER, m_indexTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	program.setUniform("clusterLights", firstUnit);
+	program.setUniform("clusterGrid", firstUnit + 1);
+	program.setUniform("clusterIndices", firstUnit + 2);
+	program.setUniform("clusterPointLights", static_cast<int32_t>(m_lights.size()));
+	program.setUniform("clusterDims", glm::vec3(TILES_X, TILES_Y, SLICES));
+	program.setUniform("clusterDepth", glm::vec2(m_near, m_far));
+	program.setUniform("screenSize", glm::vec2(screenWidth, screenHeight));
+}
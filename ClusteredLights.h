@@ -0,0 +1,143 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ShaderProgram.h"
+
+/**
+ * @brief A point light as seen by the clustered lighting path. Matches the PointLight struct
+ * in multilights.frag.
+ */
+struct PointLightData {
+	glm::vec3 position;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float_t constant;
+	float_t linear;
+	float_t quadratic;
+};
+
+/**
+ * @brief A spot light as seen by the clustered lighting path. Matches the SpotLight struct in
+ * lights.glsl; the cutoffs are the cosines of the inner and outer cone angles.
+ */
+struct SpotLightData {
+	glm::vec3 position;
+	glm::vec3 direction;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float_t constant;
+	float_t linear;
+	float_t quadratic;
+	float_t cutOff;
+	float_t outerCutOff;
+};
+
+/**
+ * @brief Bins point and spot lights into a 3D grid of view-space clusters ("froxels") so that a fragment
+ * only shades the lights whose range reaches its cluster. The grid is tiled in screen space and
+ * sliced exponentially in depth. Light data, per-cluster (offset, count) pairs and the packed
+ * light index list are uploaded each frame as texture buffers for multilights.frag compiled with
+ * CLUSTERED_LIGHTING. A spot light is binned by the bounding sphere of its cone.
+ */
+class ClusteredLights {
+public:
+	static const uint32_t TILES_X = 16;
+	static const uint32_t TILES_Y = 9;
+	static const uint32_t SLICES = 24;
+	static const uint32_t CLUSTER_COUNT = TILES_X * TILES_Y * SLICES;
+	/**
+	 * @brief A light stops contributing once its attenuated intensity falls below this.
+	 */
+	static constexpr float_t CUTOFF_INTENSITY = 1.0f / 256.0f;
+	/**
+	 * @brief The RGBA texels each light takes in the light buffer.
+	 */
+	static const uint32_t LIGHT_TEXELS = 5;
+
+private:
+	std::vector<PointLightData> m_lights;
+	std::vector<SpotLightData> m_spotLights;
+
+	// CPU-side staging for the three texture buffers.
+	std::vector<glm::vec4> m_lightTexels;
+	std::vector<uint32_t> m_grid;
+	std::vector<uint32_t> m_indices;
+	// Scratch space for binning: the cluster range touched by each light, point lights first.
+	std::vector<glm::uvec3> m_lightMin;
+	std::vector<glm::uvec3> m_lightMax;
+	std::vector<uint8_t> m_lightVisible;
+
+	uint32_t m_lightBuffer;
+	uint32_t m_lightTexture;
+	uint32_t m_gridBuffer;
+	uint32_t m_gridTexture;
+	uint32_t m_indexBuffer;
+	uint32_t m_indexTexture;
+
+	float_t m_near;
+	float_t m_far;
+
+	/**
+	 * @brief The depth slice containing the given positive view-space depth.
+	 */
+	uint32_t sliceOf(float_t depth) const;
+
+	/**
+	 * @brief Finds the clusters the light's bounding sphere touches, and counts the light in each
+	 * of them.
+	 */
+	void binLight(size_t index, const glm::vec3& center, float_t radius, const glm::mat4& view,
+		const glm::mat4& projection);
+
+	/**
+	 * @brief Computes the inclusive cluster range overlapped by the light's sphere of influence.
+	 * @return false if the sphere lies entirely outside the view frustum.
+	 */
+	bool clusterRange(const glm::vec3& viewPosition, float_t radius, const glm::mat4& projection,
+		glm::uvec3& minCluster, glm::uvec3& maxCluster) const;
+
+public:
+	ClusteredLights();
+	~ClusteredLights();
+	ClusteredLights(const ClusteredLights&) = delete;
+	ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+	/**
+	 * @brief The distance at which the given light's contribution falls below CUTOFF_INTENSITY.
+	 */
+	static float_t lightRadius(const PointLightData& light);
+	static float_t lightRadius(const SpotLightData& light);
+
+	/**
+	 * @brief The smallest sphere around the part of the spot light's cone within its radius.
+	 */
+	static void spotBounds(const SpotLightData& light, glm::vec3& center, float_t& radius);
+
+	/**
+	 * @brief Removes every light; call at the start of a frame before re-adding them.
+	 */
+	void clear();
+
+	/**
+	 * @brief Adds a light for this frame.
+	 */
+	void addLight(const PointLightData& light);
+	void addLight(const SpotLightData& light);
+
+	size_t lightCount() const;
+
+	/**
+	 * @brief Bins the current lights against the camera and uploads the results to the GPU.
+	 */
+	void update(const glm::mat4& view, const glm::mat4& projection, float_t zNear, float_t zFar);
+
+	/**
+	 * @brief Activates the program, binds the light buffers to the given texture units (three
+	 * consecutive units starting at firstUnit) and sets the uniforms the clustered shader
+	 * variant reads.
+	 */
+	void bind(ShaderProgram& program, uint32_t screenWidth, uint32_t screenHeight,
+		int32_t firstUnit = 8) const;
+};
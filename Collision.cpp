@@ -0,0 +1,251 @@
+#include "Collision.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	/**
+	 * @brief Finds when a sphere moving from start by motion first touches a point: a ray
+	 * against a sphere of the same radius around the point.
+	 */
+	bool sweepSpherePoint(const glm::vec3& start, const glm::vec3& motion, float_t radius, const glm::vec3& point,
+		float_t& fraction) {
+		glm::vec3 m = start - point;
+		float_t a = glm::dot(motion, motion);
+		float_t b = glm::dot(m, motion);
+		float_t c = glm::dot(m, m) - radius * radius;
+		// Already touching, or moving away.
+		if (c < 0 || b >= 0 || a == 0) {
+			return false;
+		}
+		float_t discriminant = b * b - a * c;
+		if (discriminant < 0) {
+			return false;
+		}
+		float_t t = (-b - std::sqrt(discriminant)) / a;
+		if (t > 1) {
+			return false;
+		}
+		fraction = t;
+		return true;
+	}
+
+	/**
+	 * @brief Finds when a sphere moving from start by motion first touches the segment pq
+	 * between its ends: a ray against a cylinder of the same radius around the segment.
+	 */
+	bool sweepSphereSegment(const glm::vec3& start, const glm::vec3& motion, float_t radius, const glm::vec3& p,
+		const glm::vec3& q, float_t& fraction) {
+		glm::vec3 d = q - p;
+		float_t dd = glm::dot(d, d);
+		if (dd == 0) {
+			return false;
+		}
+		// Solve in the plane perpendicular to the segment, where the cylinder is a circle.
+		glm::vec3 m = start - p;
+		glm::vec3 mPerpendicular = m - d * (glm::dot(m, d) / dd);
+		glm::vec3 nPerpendicular = motion - d * (glm::dot(motion, d) / dd);
+		float_t a = glm::dot(nPerpendicular, nPerpendicular);
+		float_t b = glm::dot(mPerpendicular, nPerpendicular);
+		float_t c = glm::dot(mPerpendicular, mPerpendicular) - radius * radius;
+		if (c < 0 || b >= 0 || a < 1e-12f) {
+			return false;
+		}
+		float_t discriminant = b * b - a * c;
+		if (discriminant < 0) {
+			return false;
+		}
+		float_t t = (-b - std::sqrt(discriminant)) / a;
+		if (t > 1) {
+			return false;
+		}
+		// The cylinder is infinite; beyond the ends, the corners decide.
+		float_t along = glm::dot(m + motion * t, d) / dd;
+		if (along < 0 || along > 1) {
+			return false;
+		}
+		fraction = t;
+		return true;
+	}
+}
+
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const CollisionTriangle& triangle) {
+	// Finds which feature (vertex, edge or face) of the triangle is closest, by the signs of
+	// p's barycentric coordinates; see Ericson, Real-Time Collision Detection, 5.1.5.
+	const glm::vec3& a = triangle.a;
+	const glm::vec3& b = triangle.b;
+	const glm::vec3& c = triangle.c;
+	glm::vec3 ab = b - a;
+	glm::vec3 ac = c - a;
+	glm::vec3 ap = p - a;
+	float_t d1 = glm::dot(ab, ap);
+	float_t d2 = glm::dot(ac, ap);
+	if (d1 <= 0 && d2 <= 0) {
+		return a;
+	}
+	glm::vec3 bp = p - b;
+	float_t d3 = glm::dot(ab, bp);
+	float_t d4 = glm::dot(ac, bp);
+	if (d3 >= 0 && d4 <= d3) {
+		return b;
+	}
+	float_t vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+		return a + ab * (d1 / (d1 - d3));
+	}
+	glm::vec3 cp = p - c;
+	float_t d5 = glm::dot(ab, cp);
+	float_t d6 = glm::dot(ac, cp);
+	if (d6 >= 0 && d5 <= d6) {
+		return c;
+	}
+	float_t vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+		return a + ac * (d2 / (d2 - d6));
+	}
+	float_t va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0) {
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+	float_t denominator = 1 / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+bool sweepSphereBox(const glm::vec3& start, const glm::vec3& motion, float_t radius, const BoundingBox& box,
+	float_t& fraction, glm::vec3& normal) {
+	// A ray against the box grown by the radius, by the slab method. The grown box has square
+	// rather than rounded edges, so a sphere grazing an edge stops slightly early.
+	glm::vec3 low = box.min - radius;
+	glm::vec3 high = box.max + radius;
+	float_t enter = -std::numeric_limits<float_t>::max();
+	float_t exit = std::numeric_limits<float_t>::max();
+	int32_t enterAxis = -1;
+	for (int32_t axis = 0; axis < 3; axis++) {
+		if (std::abs(motion[axis]) < 1e-12f) {
+			if (start[axis] < low[axis] || start[axis] > high[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float_t t0 = (low[axis] - start[axis]) / motion[axis];
+		float_t t1 = (high[axis] - start[axis]) / motion[axis];
+		if (t0 > t1) {
+			std::swap(t0, t1);
+		}
+		if (t0 > enter) {
+			enter = t0;
+			enterAxis = axis;
+		}
+		exit = std::min(exit, t1);
+	}
+	// Starting inside the grown box is a touching contact, which the discrete test resolves.
+	if (enterAxis < 0 || enter > exit || enter < 0 || enter > 1) {
+		return false;
+	}
+	fraction = enter;
+	normal = glm::vec3(0);
+	normal[enterAxis] = motion[enterAxis] > 0 ? -1.0f : 1.0f;
+	return true;
+}
+
+bool sweepSphereTriangle(const glm::vec3& start, const glm::vec3& motion, float_t radius,
+	const CollisionTriangle& triangle, float_t& fraction, glm::vec3& normal) {
+	glm::vec3 faceNormal = glm::cross(triangle.b - triangle.a, triangle.c - triangle.a);
+	float_t area = glm::length(faceNormal);
+	if (area == 0) {
+		return false;
+	}
+	faceNormal = faceNormal / area;
+	// Face the side the sphere starts on.
+	float_t height = glm::dot(start - triangle.a, faceNormal);
+	if (height < 0) {
+		faceNormal = -faceNormal;
+		height = -height;
+	}
+	float_t approach = glm::dot(motion, faceNormal);
+	float_t t;
+	if (approach < 0 && height >= radius) {
+		// When the sphere's lowest point reaches the plane, it must be on the face.
+		t = (height - radius) / -approach;
+		if (t > 1) {
+			return false;
+		}
+		glm::vec3 contact = start + motion * t - faceNormal * radius;
+		glm::vec3 offset = contact - closestPointOnTriangle(contact, triangle);
+		if (glm::dot(offset, offset) <= 1e-8f) {
+			fraction = t;
+			normal = faceNormal;
+			return true;
+		}
+	}
+
+	// The sphere misses the face, so it can only touch an edge or a corner.
+	const glm::vec3* corners[] = { &triangle.a, &triangle.b, &triangle.c };
+	float_t first = std::numeric_limits<float_t>::max();
+	glm::vec3 touched;
+	for (int32_t i = 0; i < 3; i++) {
+		const glm::vec3& p = *corners[i];
+		const glm::vec3& q = *corners[(i + 1) % 3];
+		if (sweepSphereSegment(start, motion, radius, p, q, t) && t < first) {
+			first = t;
+			glm::vec3 center = start + motion * t;
+			glm::vec3 d = q - p;
+			touched = p + d * (glm::dot(center - p, d) / glm::dot(d, d));
+		}
+		if (sweepSpherePoint(start, motion, radius, p, t) && t < first) {
+			first = t;
+			touched = p;
+		}
+	}
+	if (first > 1) {
+		return false;
+	}
+	fraction = first;
+	normal = glm::normalize(start + motion * first - touched);
+	return true;
+}
+
+bool rayTriangle(const glm::vec3& origin, const glm::vec3& direction, const CollisionTriangle& triangle,
+	float_t& distance) {
+	// Moller-Trumbore: solve origin + t * direction = a + u * ab + v * ac for (t, u, v).
+	glm::vec3 ab = triangle.b - triangle.a;
+	glm::vec3 ac = triangle.c - triangle.a;
+	glm::vec3 p = glm::cross(direction, ac);
+	float_t determinant = glm::dot(ab, p);
+	if (std::abs(determinant) < 1e-12f) {
+		// The ray is parallel to the triangle.
+		return false;
+	}
+	float_t inverse = 1 / determinant;
+	glm::vec3 s = origin - triangle.a;
+	float_t u = glm::dot(s, p) * inverse;
+	if (u < 0 || u > 1) {
+		return false;
+	}
+	glm::vec3 q = glm::cross(s, ab);
+	float_t v = glm::dot(direction, q) * inverse;
+	if (v < 0 || u + v > 1) {
+		return false;
+	}
+	float_t t = glm::dot(ac, q) * inverse;
+	if (t < 0) {
+		return false;
+	}
+	distance = t;
+	return true;
+}
+
+bool rayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const BoundingBox& box, float_t maxDistance,
+	float_t& distance) {
+	glm::vec3 t0 = (box.min - origin) * inverseDirection;
+	glm::vec3 t1 = (box.max - origin) * inverseDirection;
+	glm::vec3 entries = glm::min(t0, t1);
+	glm::vec3 exits = glm::max(t0, t1);
+	float_t enter = std::max(std::max(entries.x, entries.y), std::max(entries.z, 0.0f));
+	float_t exit = std::min(std::min(exits.x, exits.y), std::min(exits.z, maxDistance));
+	if (enter > exit) {
+		return false;
+	}
+	distance = enter;
+	return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+
+/**
+ * @brief A triangle of static collision geometry.
+ */
+struct CollisionTriangle {
+	glm::vec3 a;
+	glm::vec3 b;
+	glm::vec3 c;
+};
+
+/**
+ * @brief The point of the triangle closest to p.
+ */
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const CollisionTriangle& triangle);
+
+/**
+ * @brief Finds when a sphere moving from start by motion first touches the box: a ray cast
+ * against the box grown by the radius. Spheres already touching the box are not reported.
+ * @param fraction receives the fraction of motion before contact, in [0, 1].
+ * @param normal receives the box's face normal at the contact.
+ */
+bool sweepSphereBox(const glm::vec3& start, const glm::vec3& motion, float_t radius, const BoundingBox& box,
+	float_t& fraction, glm::vec3& normal);
+
+/**
+ * @brief Finds when a sphere moving from start by motion first touches the triangle: its face,
+ * or failing that, one of its edges or corners. Spheres already touching the triangle are not
+ * reported.
+ */
+bool sweepSphereTriangle(const glm::vec3& start, const glm::vec3& motion, float_t radius,
+	const CollisionTriangle& triangle, float_t& fraction, glm::vec3& normal);
+
+/**
+ * @brief Intersects a ray with a triangle, from either side.
+ * @param distance receives the distance along the (unit) direction to the hit.
+ */
+bool rayTriangle(const glm::vec3& origin, const glm::vec3& direction, const CollisionTriangle& triangle,
+	float_t& distance);
+
+/**
+ * @brief Intersects a ray with a box by the slab method, given the reciprocal of the ray's
+ * direction. A ray starting inside the box hits it at distance 0.
+ * @param distance receives the distance at which the ray enters the box.
+ */
+bool rayBox(const glm::vec3& origin, const glm::vec3& inverseDirection, const BoundingBox& box, float_t maxDistance,
+	float_t& distance);
@@ -0,0 +1,207 @@
+#include "DynamicAABBTree.h"
+#include <algorithm>
+
+namespace {
+	// How far ahead of a moving proxy its fat box reaches, in steps of its last displacement.
+	const float_t DISPLACEMENT_MULTIPLIER = 2;
+
+	float_t surfaceArea(const BoundingBox& box) {
+		glm::vec3 size = box.max - box.min;
+		return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	BoundingBox combine(const BoundingBox& a, const BoundingBox& b) {
+		return BoundingBox(glm::min(a.min, b.min), glm::max(a.max, b.max));
+	}
+}
+
+DynamicAABBTree::DynamicAABBTree(float_t margin) : m_root(NONE), m_free(NONE), m_margin(margin) {
+}
+
+int32_t DynamicAABBTree::allocateNode() {
+	if (m_free == NONE) {
+		m_nodes.push_back(Node{ BoundingBox(), NONE, NONE, NONE, 0, 0 });
+		return static_cast<int32_t>(m_nodes.size() - 1);
+	}
+	int32_t node = m_free;
+	m_free = m_nodes[node].parent;
+	m_nodes[node] = Node{ BoundingBox(), NONE, NONE, NONE, 0, 0 };
+	return node;
+}
+
+void DynamicAABBTree::freeNode(int32_t node) {
+	m_nodes[node].parent = m_free;
+	m_nodes[node].left = NONE;
+	m_nodes[node].right = NONE;
+	m_nodes[node].height = -1;
+	m_free = node;
+}
+
+BoundingBox DynamicAABBTree::fatten(const BoundingBox& box, const glm::vec3& displacement) const {
+	BoundingBox fat(box.min - m_margin, box.max + m_margin);
+	glm::vec3 ahead = displacement * DISPLACEMENT_MULTIPLIER;
+	fat.min += glm::min(ahead, glm::vec3(0));
+	fat.max += glm::max(ahead, glm::vec3(0));
+	return fat;
+}
+
+int32_t DynamicAABBTree::insert(const BoundingBox& box, uint32_t userData) {
+	int32_t leaf = allocateNode();
+	m_nodes[leaf].box = fatten(box, glm::vec3(0));
+	m_nodes[leaf].userData = userData;
+	insertLeaf(leaf);
+	return leaf;
+}
+
+void DynamicAABBTree::remove(int32_t proxy) {
+	removeLeaf(proxy);
+	freeNode(proxy);
+}
+
+bool DynamicAABBTree::move(int32_t proxy, const BoundingBox& box, const glm::vec3& displacement) {
+	const BoundingBox& fat = m_nodes[proxy].box;
+	if (fat.contains(box.min) && fat.contains(box.max)) {
+		return false;
+	}
+	removeLeaf(proxy);
+	m_nodes[proxy].box = fatten(box, displacement);
+	insertLeaf(proxy);
+	return true;
+}
+
+uint32_t DynamicAABBTree::userData(int32_t proxy) const {
+	return m_nodes[proxy].userData;
+}
+
+const BoundingBox& DynamicAABBTree::fatBox(int32_t proxy) const {
+	return m_nodes[proxy].box;
+}
+
+int32_t DynamicAABBTree::height() const {
+	return m_root == NONE ? 0 : m_nodes[m_root].height;
+}
+
+void DynamicAABBTree::insertLeaf(int32_t leaf) {
+	if (m_root == NONE) {
+		m_root = leaf;
+		m_nodes[leaf].parent = NONE;
+		return;
+	}
+
+	// Walk down to the best sibling: at each node, stop here if pairing the leaf with this node
+	// costs less than the cheapest descent into either child. Cost is the area added to the tree.
+	BoundingBox box = m_nodes[leaf].box;
+	int32_t index = m_root;
+	while (!m_nodes[index].isLeaf()) {
+		const Node& node = m_nodes[index];
+		float_t area = surfaceArea(node.box);
+		float_t combinedArea = surfaceArea(combine(node.box, box));
+		// Pairing here makes a new parent with the combined box.
+		float_t cost = 2 * combinedArea;
+		// Descending grows this node's box either way, by the same amount.
+		float_t inheritance = 2 * (combinedArea - area);
+		auto descendCost = [&](int32_t child) {
+			const BoundingBox& childBox = m_nodes[child].box;
+			float_t grown = surfaceArea(combine(childBox, box));
+			return m_nodes[child].isLeaf() ? grown + inheritance : grown - surfaceArea(childBox) + inheritance;
+		};
+		float_t leftCost = descendCost(node.left);
+		float_t rightCost = descendCost(node.right);
+		if (cost < leftCost && cost < rightCost) {
+			break;
+		}
+		index = leftCost < rightCost ? node.left : node.right;
+	}
+
+	// Replace the sibling with a new parent of the sibling and the leaf.
+	int32_t sibling = index;
+	int32_t oldParent = m_nodes[sibling].parent;
+	int32_t parent = allocateNode();
+	m_nodes[parent].parent = oldParent;
+	m_nodes[parent].box = combine(m_nodes[sibling].box, box);
+	m_nodes[parent].left = sibling;
+	m_nodes[parent].right = leaf;
+	m_nodes[parent].height = m_nodes[sibling].height + 1;
+	m_nodes[sibling].parent = parent;
+	m_nodes[leaf].parent = parent;
+	replaceChild(oldParent, sibling, parent);
+	refit(oldParent);
+}
+
+void DynamicAABBTree::removeLeaf(int32_t leaf) {
+	if (leaf == m_root) {
+		m_root = NONE;
+		return;
+	}
+	// The leaf's sibling takes its parent's place.
+	int32_t parent = m_nodes[leaf].parent;
+	int32_t grandParent = m_nodes[parent].parent;
+	int32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+	m_nodes[sibling].parent = grandParent;
+	replaceChild(grandParent, parent, sibling);
+	refit(grandParent);
+	freeNode(parent);
+}
+
+void DynamicAABBTree::replaceChild(int32_t parent, int32_t oldChild, int32_t newChild) {
+	if (parent == NONE) {
+		m_root = newChild;
+	}
+	else if (m_nodes[parent].left == oldChild) {
+		m_nodes[parent].left = newChild;
+	}
+	else {
+		m_nodes[parent].right = newChild;
+	}
+}
+
+void DynamicAABBTree::refit(int32_t node) {
+	while (node != NONE) {
+		node = balance(node);
+		Node& n = m_nodes[node];
+		n.box = combine(m_nodes[n.left].box, m_nodes[n.right].box);
+		n.height = 1 + std::max(m_nodes[n.left].height, m_nodes[n.right].height);
+		node = n.parent;
+	}
+}
+
+int32_t DynamicAABBTree::balance(int32_t a) {
+	if (m_nodes[a].isLeaf() || m_nodes[a].height < 2) {
+		return a;
+	}
+	int32_t b = m_nodes[a].left;
+	int32_t c = m_nodes[a].right;
+	int32_t skew = m_nodes[c].height - m_nodes[b].height;
+	if (skew >= -1 && skew <= 1) {
+		return a;
+	}
+
+	// The taller child rises to a's place, and a takes the taller child's shorter child,
+	// keeping its taller child itself.
+	bool rightTaller = skew > 1;
+	int32_t up = rightTaller ? c : b;
+	int32_t stay = rightTaller ? b : c;
+	int32_t first = m_nodes[up].left;
+	int32_t second = m_nodes[up].right;
+	int32_t kept = m_nodes[first].height > m_nodes[second].height ? first : second;
+	int32_t given = kept == first ? second : first;
+
+	m_nodes[up].parent = m_nodes[a].parent;
+	replaceChild(m_nodes[a].parent, a, up);
+	m_nodes[up].left = a;
+	m_nodes[up].right = kept;
+	m_nodes[a].parent = up;
+	if (rightTaller) {
+		m_nodes[a].right = given;
+	}
+	else {
+		m_nodes[a].left = given;
+	}
+	m_nodes[given].parent = a;
+
+	m_nodes[a].box = combine(m_nodes[stay].box, m_nodes[given].box);
+	m_nodes[a].height = 1 + std::max(m_nodes[stay].height, m_nodes[given].height);
+	m_nodes[up].box = combine(m_nodes[a].box, m_nodes[kept].box);
+	m_nodes[up].height = 1 + std::max(m_nodes[a].height, m_nodes[kept].height);
+	return up;
+}
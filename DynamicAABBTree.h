@@ -0,0 +1,188 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Collision.h"
+#include "Frustum.h"
+
+/**
+ * @brief A bounding volume hierarchy over boxes that come, go and move, for finding which of
+ * many objects a box, sphere or ray reaches in logarithmic time.
+ *
+ * Each entry, a proxy, is stored in a leaf with a fattened copy of its box: the box grown by a
+ * margin on every side, and stretched ahead along the proxy's last movement. Moving a proxy only
+ * touches the tree when its new box leaves the fat box, so objects that move a little each frame
+ * are reinserted only every few frames. A new leaf is placed beside the node whose combined box
+ * grows the tree's total area least. On the way back up every ancestor's box is refit, and any
+ * ancestor whose subtrees differ in height by more than one is rotated, as in an AVL tree, so
+ * the tree stays O(log n) deep however objects are added and moved.
+ *
+ * Nodes live in one array, linked by index, with free nodes kept on a list for reuse.
+ */
+class DynamicAABBTree {
+private:
+	static const int32_t NONE = -1;
+
+	struct Node {
+		BoundingBox box;
+		// While in use the parent; while free, the next free node.
+		int32_t parent;
+		int32_t left;
+		int32_t right;
+		// The leaf's caller-defined value.
+		uint32_t userData;
+		// Levels below the node: 0 for leaves, -1 for free nodes.
+		int32_t height;
+
+		bool isLeaf() const { return left == NONE; }
+	};
+
+	std::vector<Node> m_nodes;
+	int32_t m_root;
+	int32_t m_free;
+	float_t m_margin;
+	// Scratch stack for traversals.
+	mutable std::vector<int32_t> m_stack;
+
+	int32_t allocateNode();
+	void freeNode(int32_t node);
+	void insertLeaf(int32_t leaf);
+	void removeLeaf(int32_t leaf);
+	BoundingBox fatten(const BoundingBox& box, const glm::vec3& displacement) const;
+	/**
+	 * @brief Recomputes the boxes and heights of the node and each of its ancestors from their
+	 * children, rebalancing each on the way.
+	 */
+	void refit(int32_t node);
+	/**
+	 * @brief If one subtree of the node is more than a level taller than the other, rotates the
+	 * taller one's child up in its place.
+	 * @return the node now at the top of the subtree.
+	 */
+	int32_t balance(int32_t node);
+	void replaceChild(int32_t parent, int32_t oldChild, int32_t newChild);
+
+public:
+	/**
+	 * @brief Constructs an empty tree, which fattens boxes by the given margin.
+	 */
+	explicit DynamicAABBTree(float_t margin = 0.5f);
+
+	/**
+	 * @brief Adds a box with a value for queries to report.
+	 * @return the proxy id, valid until the proxy is removed.
+	 */
+	int32_t insert(const BoundingBox& box, uint32_t userData);
+	void remove(int32_t proxy);
+
+	/**
+	 * @brief Updates a proxy's box. The displacement since the last update stretches the new fat
+	 * box ahead of the proxy, so steady motion reinserts it less often.
+	 * @return whether the proxy left its fat box and was reinserted.
+	 */
+	bool move(int32_t proxy, const BoundingBox& box, const glm::vec3& displacement = glm::vec3(0));
+
+	uint32_t userData(int32_t proxy) const;
+	const BoundingBox& fatBox(int32_t proxy) const;
+
+	/**
+	 * @brief The number of levels below the root; 0 for an empty tree.
+	 */
+	int32_t height() const;
+
+	/**
+	 * @brief Calls found(proxy) for each proxy whose fat box overlaps the box.
+	 */
+	template <typename F>
+	void query(const BoundingBox& box, F&& found) const {
+		if (m_root == NONE) {
+			return;
+		}
+		m_stack.clear();
+		m_stack.push_back(m_root);
+		while (!m_stack.empty()) {
+			int32_t index = m_stack.back();
+			m_stack.pop_back();
+			const Node& node = m_nodes[index];
+			if (!node.box.overlaps(box)) {
+				continue;
+			}
+			if (node.isLeaf()) {
+				found(index);
+			}
+			else {
+				m_stack.push_back(node.left);
+				m_stack.push_back(node.right);
+			}
+		}
+	}
+
+	/**
+	 * @brief Calls found(proxy) for each proxy whose fat box is at least partly inside the
+	 * frustum. Subtrees entirely inside are reported without testing their boxes.
+	 */
+	template <typename F>
+	void query(const Frustum& frustum, F&& found) const {
+		if (m_root == NONE) {
+			return;
+		}
+		// Each entry carries whether its subtree is already known to be inside.
+		m_stack.clear();
+		m_stack.push_back(m_root);
+		while (!m_stack.empty()) {
+			int32_t entry = m_stack.back();
+			m_stack.pop_back();
+			bool inside = entry < 0;
+			int32_t index = inside ? ~entry : entry;
+			const Node& node = m_nodes[index];
+			if (!inside) {
+				Frustum::Test test = frustum.test(node.box);
+				if (test == Frustum::Test::Outside) {
+					continue;
+				}
+				inside = test == Frustum::Test::Inside;
+			}
+			if (node.isLeaf()) {
+				found(index);
+			}
+			else {
+				m_stack.push_back(inside ? ~node.left : node.left);
+				m_stack.push_back(inside ? ~node.right : node.right);
+			}
+		}
+	}
+
+	/**
+	 * @brief Calls hit(proxy, maxDistance) for each proxy whose fat box the ray enters within
+	 * maxDistance. The callback returns the distance to search up to from then on: maxDistance
+	 * to keep going, less to clip the ray at a hit, or 0 to stop.
+	 * @param direction the ray's direction, of unit length.
+	 */
+	template <typename F>
+	void raycast(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance, F&& hit) const {
+		if (m_root == NONE) {
+			return;
+		}
+		auto inverse = [](float_t x) { return x != 0 ? 1 / x : 1e20f; };
+		glm::vec3 inverseDirection(inverse(direction.x), inverse(direction.y), inverse(direction.z));
+		m_stack.clear();
+		m_stack.push_back(m_root);
+		while (!m_stack.empty() && maxDistance > 0) {
+			int32_t index = m_stack.back();
+			m_stack.pop_back();
+			const Node& node = m_nodes[index];
+			float_t entry;
+			if (!rayBox(origin, inverseDirection, node.box, maxDistance, entry)) {
+				continue;
+			}
+			if (node.isLeaf()) {
+				maxDistance = hit(index, maxDistance);
+			}
+			else {
+				m_stack.push_back(node.left);
+				m_stack.push_back(node.right);
+			}
+		}
+	}
+};
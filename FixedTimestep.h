@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+
+/**
+ * @brief Turns variable frame times into a whole number of fixed simulation steps. Each frame
+ * adds its elapsed time with advance(), then calls step() until it returns false, running one
+ * simulation step per true. The time left over is reported by alpha() as a fraction of a step,
+ * for blending the last two simulated states when rendering.
+ */
+class FixedTimestep {
+private:
+	float_t m_step;
+	float_t m_accumulator;
+	uint32_t m_maxSteps;
+
+public:
+	/**
+	 * @brief Constructs a stepper with the given step length, in seconds. At most maxSteps steps
+	 * are run per frame; after a longer stall the simulation slows down rather than spending ever
+	 * more time catching up.
+	 */
+	FixedTimestep(float_t step, uint32_t maxSteps = 8) : m_step(step), m_accumulator(0), m_maxSteps(maxSteps) {}
+
+	/**
+	 * @brief The length of one step, in seconds.
+	 */
+	float_t stepSize() const { return m_step; }
+
+	/**
+	 * @brief Adds a frame's elapsed time, in seconds.
+	 */
+	void advance(float_t dt) {
+		m_accumulator = std::min(m_accumulator + dt, m_step * m_maxSteps);
+	}
+
+	/**
+	 * @brief Consumes one step's worth of time if enough has accumulated.
+	 * @return whether a step should be simulated.
+	 */
+	bool step() {
+		if (m_accumulator < m_step) {
+			return false;
+		}
+		m_accumulator -= m_step;
+		return true;
+	}
+
+	/**
+	 * @brief How far between the last step and the next one the current time is, from 0 to 1.
+	 */
+	float_t alpha() const { return m_accumulator / m_step; }
+};
@@ -0,0 +1,45 @@
+#include "FramePipeline.h"
+#include <utility>
+
+FramePipeline::FramePipeline()
+	: m_building(&m_snapshots[0]), m_pending(&m_snapshots[1]), m_drawing(&m_snapshots[2]),
+	m_hasPending(false), m_closed(false) {
+}
+
+RenderSnapshot& FramePipeline::building() {
+	// Only the simulation thread touches this snapshot, so no lock is needed. Clearing it here
+	// destroys the objects it retired, which no snapshot still in flight can draw.
+	m_building->clear();
+	return *m_building;
+}
+
+bool FramePipeline::publish() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_taken.wait(lock, [this]() { return !m_hasPending || m_closed; });
+	if (m_closed) {
+		return false;
+	}
+	std::swap(m_building, m_pending);
+	m_hasPending = true;
+	m_published.notify_one();
+	return true;
+}
+
+const RenderSnapshot* FramePipeline::acquire() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_published.wait(lock, [this]() { return m_hasPending || m_closed; });
+	if (m_closed) {
+		return nullptr;
+	}
+	std::swap(m_pending, m_drawing);
+	m_hasPending = false;
+	m_taken.notify_one();
+	return m_drawing;
+}
+
+void FramePipeline::close() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_closed = true;
+	m_published.notify_all();
+	m_taken.notify_all();
+}
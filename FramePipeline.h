@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include "RenderSnapshot.h"
+
+/**
+ * @brief Hands render snapshots from the simulation thread to the render thread, so the next
+ * frame is simulated while the current one is drawn. There are three snapshots: the one being
+ * built, the one waiting to be drawn, and the one being drawn. The simulation runs at most one
+ * frame ahead of rendering; the render thread waits until a new frame is published.
+ */
+class FramePipeline {
+private:
+	RenderSnapshot m_snapshots[3];
+	RenderSnapshot* m_building;
+	RenderSnapshot* m_pending;
+	RenderSnapshot* m_drawing;
+	// Whether m_pending holds a published frame the render thread has not taken.
+	bool m_hasPending;
+	bool m_closed;
+
+	std::mutex m_mutex;
+	std::condition_variable m_published;
+	std::condition_variable m_taken;
+
+public:
+	FramePipeline();
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	/**
+	 * @brief The snapshot for the simulation thread to fill, already cleared.
+	 */
+	RenderSnapshot& building();
+
+	/**
+	 * @brief Publishes the built snapshot, first waiting for the render thread to take the
+	 * previous one.
+	 * @return false if the pipeline was closed.
+	 */
+	bool publish();
+
+	/**
+	 * @brief Waits for the next published snapshot and hands it to the render thread, which may
+	 * read it until its next call to acquire().
+	 * @return the snapshot, or nullptr if the pipeline was closed.
+	 */
+	const RenderSnapshot* acquire();
+
+	/**
+	 * @brief Wakes both threads and makes every later publish() and acquire() fail.
+	 */
+	void close();
+};
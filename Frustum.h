@@ -0,0 +1,62 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+
+/**
+ * @brief The six planes of a view frustum, for testing what a camera can see. Each plane is
+ * (normal, distance) with the normal pointing into the frustum.
+ */
+struct Frustum {
+	enum class Test {
+		Outside,
+		Intersects,
+		Inside
+	};
+
+	glm::vec4 planes[6];
+
+	/**
+	 * @brief Extracts the planes of a projection * view matrix (Gribb and Hartmann's method).
+	 */
+	static Frustum fromMatrix(const glm::mat4& viewProjection) {
+		// Rows of the matrix; glm stores columns.
+		glm::vec4 rows[4];
+		for (int32_t i = 0; i < 4; i++) {
+			rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		}
+		Frustum frustum;
+		frustum.planes[0] = rows[3] + rows[0];
+		frustum.planes[1] = rows[3] - rows[0];
+		frustum.planes[2] = rows[3] + rows[1];
+		frustum.planes[3] = rows[3] - rows[1];
+		frustum.planes[4] = rows[3] + rows[2];
+		frustum.planes[5] = rows[3] - rows[2];
+		for (auto& plane : frustum.planes) {
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	/**
+	 * @brief Classifies the box against the frustum by each plane's nearest and farthest box
+	 * corners. Boxes near the frustum's corners may be reported as intersecting when they are
+	 * just outside.
+	 */
+	Test test(const BoundingBox& box) const {
+		Test result = Test::Inside;
+		for (auto& plane : planes) {
+			glm::vec3 normal(plane);
+			glm::vec3 farthest(normal.x >= 0 ? box.max.x : box.min.x, normal.y >= 0 ? box.max.y : box.min.y,
+				normal.z >= 0 ? box.max.z : box.min.z);
+			glm::vec3 nearest(normal.x >= 0 ? box.min.x : box.max.x, normal.y >= 0 ? box.min.y : box.max.y,
+				normal.z >= 0 ? box.min.z : box.max.z);
+			if (glm::dot(normal, farthest) + plane.w < 0) {
+				return Test::Outside;
+			}
+			if (glm::dot(normal, nearest) + plane.w < 0) {
+				result = Test::Intersects;
+			}
+		}
+		return result;
+	}
+};
@@ -0,0 +1,116 @@
+#include "JobSystem.h"
+
+namespace {
+	// The job system that owns the calling thread, if it is a worker, and the worker's queue.
+	thread_local const JobSystem* t_owner = nullptr;
+	thread_local uint32_t t_queue = 0;
+}
+
+JobSystem::JobSystem(uint32_t workerCount) : m_stopping(false), m_queued(0) {
+	workerCount = std::max<uint32_t>(workerCount, 1);
+	for (uint32_t i = 0; i <= workerCount; i++) {
+		m_queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (uint32_t i = 0; i < workerCount; i++) {
+		m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+uint32_t JobSystem::defaultWorkerCount() {
+	uint32_t cores = std::thread::hardware_concurrency();
+	return cores > 2 ? cores - 2 : 1;
+}
+
+uint32_t JobSystem::workerCount() const {
+	return static_cast<uint32_t>(m_workers.size());
+}
+
+uint32_t JobSystem::queueIndex() const {
+	return t_owner == this ? t_queue : static_cast<uint32_t>(m_workers.size());
+}
+
+void JobSystem::run(std::function<void()> work, JobCounter& counter) {
+	counter.m_pending++;
+	WorkQueue& queue = *m_queues[queueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(Job{ std::move(work), &counter });
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queued++;
+	}
+	m_wake.notify_one();
+}
+
+bool JobSystem::takeJob(Job& job) {
+	uint32_t own = queueIndex();
+	{
+		// Newest first from our own queue: its data is most likely still in cache.
+		WorkQueue& queue = *m_queues[own];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			return true;
+		}
+	}
+	// Oldest first from the others, which tend to be the largest remaining pieces of work.
+	uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+	for (uint32_t i = 1; i < queueCount; i++) {
+		WorkQueue& queue = *m_queues[(own + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobSystem::runOne() {
+	Job job;
+	if (!takeJob(job)) {
+		return false;
+	}
+	m_queued--;
+	job.work();
+	job.counter->m_pending--;
+	return true;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+	while (!counter.done()) {
+		if (!runOne()) {
+			// The remaining jobs are running on other threads.
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::workerLoop(uint32_t index) {
+	t_owner = this;
+	t_queue = index;
+	while (true) {
+		if (runOne()) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wake.wait(lock, [this]() { return m_queued > 0 || m_stopping; });
+		if (m_stopping) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Counts a group of jobs that have not finished. Jobs added with the same counter can be
+ * waited on together, and a job that needs the results of others waits on their counter first.
+ */
+class JobCounter {
+private:
+	std::atomic<uint32_t> m_pending;
+	friend class JobSystem;
+
+public:
+	JobCounter() : m_pending(0) {}
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool done() const { return m_pending.load() == 0; }
+};
+
+/**
+ * @brief A pool of worker threads that run small jobs. Each worker has its own queue: it takes
+ * its newest job first, while idle workers steal the oldest jobs from the others, so work
+ * spreads across cores without every thread contending for one shared queue. Threads outside
+ * the pool share one more queue.
+ *
+ * A thread waiting on a counter runs queued jobs until the counter reaches zero, rather than
+ * blocking, so jobs may themselves add and wait on jobs.
+ */
+class JobSystem {
+private:
+	struct Job {
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	// One queue per worker, then the queue for outside threads.
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+	std::atomic<bool> m_stopping;
+	// The number of jobs in all queues; idle workers sleep while it is zero.
+	std::atomic<uint32_t> m_queued;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wake;
+
+	/**
+	 * @brief The queue of the calling thread.
+	 */
+	uint32_t queueIndex() const;
+
+	/**
+	 * @brief Takes a job from the calling thread's own queue, or else steals one from another.
+	 */
+	bool takeJob(Job& job);
+
+	/**
+	 * @brief Runs one queued job, if there is any.
+	 * @return whether a job was run.
+	 */
+	bool runOne();
+
+	void workerLoop(uint32_t index);
+
+public:
+	/**
+	 * @brief Starts the given number of workers. By default, one per core, less one each for the
+	 * simulation and render threads.
+	 */
+	JobSystem(uint32_t workerCount = defaultWorkerCount());
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+
+	static uint32_t defaultWorkerCount();
+	uint32_t workerCount() const;
+
+	/**
+	 * @brief Queues a job. The counter counts it until it has run.
+	 */
+	void run(std::function<void()> work, JobCounter& counter);
+
+	/**
+	 * @brief Runs queued jobs until every job counted by the counter has finished.
+	 */
+	void wait(JobCounter& counter);
+
+	/**
+	 * @brief Calls body(i) for every i in [0, count), in batches of batchSize indices run as
+	 * parallel jobs, and returns when all have finished. Calls for different indices must not
+	 * touch the same data. A single batch runs inline.
+	 */
+	template <typename F>
+	void parallelFor(size_t count, size_t batchSize, F&& body) {
+		batchSize = std::max<size_t>(batchSize, 1);
+		if (count <= batchSize) {
+			for (size_t i = 0; i < count; i++) {
+				body(i);
+			}
+			return;
+		}
+		JobCounter counter;
+		for (size_t begin = 0; begin < count; begin += batchSize) {
+			size_t end = std::min(count, begin + batchSize);
+			run([&body, begin, end]() {
+				for (size_t i = begin; i < end; i++) {
+					body(i);
+				}
+			}, counter);
+		}
+		wait(counter);
+	}
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+/**
+ * @brief How a KeyframeTrack fills the time between two keys.
+ */
+enum class Interpolation {
+	// Hold each key's value until the next key.
+	Step,
+	// Blend straight from one key to the next.
+	Linear,
+	// A Catmull-Rom style cubic through the keys, smooth across them.
+	Cubic
+};
+
+/**
+ * @brief A value of a track at a specific time.
+ */
+template <typename T>
+struct Keyframe {
+	float_t time;
+	T value;
+};
+
+/**
+ * @brief Linear interpolation between two key values. Overload for types that do not blend
+ * component-wise.
+ */
+template <typename T>
+T interpolateLinear(const T& a, const T& b, float_t t) {
+	return a + (b - a) * t;
+}
+
+/**
+ * @brief Cubic Hermite interpolation between a and b with tangents ta and tb (already scaled by
+ * the interval length).
+ */
+template <typename T>
+T interpolateCubic(const T& a, const T& ta, const T& b, const T& tb, float_t t) {
+	float_t t2 = t * t;
+	float_t t3 = t2 * t;
+	return a * (2 * t3 - 3 * t2 + 1) + ta * (t3 - 2 * t2 + t) + b * (-2 * t3 + 3 * t2) + tb * (t3 - t2);
+}
+
+/**
+ * @brief Rotations blend along the shortest arc of the unit sphere.
+ */
+inline glm::quat interpolateLinear(const glm::quat& a, const glm::quat& b, float_t t) {
+	return glm::slerp(a, b, t);
+}
+
+/**
+ * @brief Rotation tracks have no cubic form; they fall back to the shortest-arc blend.
+ */
+inline glm::quat interpolateCubic(const glm::quat& a, const glm::quat& /*ta*/, const glm::quat& b,
+	const glm::quat& /*tb*/, float_t t) {
+	return glm::slerp(a, b, t);
+}
+
+/**
+ * @brief A curve defined by keyframes sorted by time, sampled by absolute time. Sampling is a
+ * binary search for the surrounding keys, O(log keys), and never depends on earlier samples;
+ * so the same time always gives the same value, however the track is stepped, seeked or skipped.
+ */
+template <typename T>
+class KeyframeTrack {
+private:
+	std::vector<Keyframe<T>> m_keys;
+	Interpolation m_interpolation;
+
+	/**
+	 * @brief The slope of the curve at key i: a finite difference of the neighbouring keys. A
+	 * neighbour at the same time as the key is the other side of a cut, so it is not used.
+	 */
+	T tangent(size_t i) const {
+		size_t prev = i > 0 && m_keys[i - 1].time < m_keys[i].time ? i - 1 : i;
+		size_t next = i + 1 < m_keys.size() && m_keys[i + 1].time > m_keys[i].time ? i + 1 : i;
+		float_t span = m_keys[next].time - m_keys[prev].time;
+		if (span <= 0) {
+			return m_keys[i].value * 0.0f;
+		}
+		return (m_keys[next].value - m_keys[prev].value) * (1.0f / span);
+	}
+
+public:
+	KeyframeTrack(Interpolation interpolation = Interpolation::Linear) : m_interpolation(interpolation) {}
+
+	Interpolation interpolation() const { return m_interpolation; }
+	void setInterpolation(Interpolation interpolation) { m_interpolation = interpolation; }
+
+	const std::vector<Keyframe<T>>& keys() const { return m_keys; }
+	bool empty() const { return m_keys.empty(); }
+
+	/**
+	 * @brief The time of the last key.
+	 */
+	float_t duration() const { return m_keys.empty() ? 0 : m_keys.back().time; }
+
+	/**
+	 * @brief Adds a key, keeping the keys sorted. A key added at the same time as an existing
+	 * key goes after it, which allows instant jumps.
+	 */
+	void addKey(float_t time, const T& value) {
+		auto at = std::upper_bound(m_keys.begin(), m_keys.end(), time,
+			[](float_t t, const Keyframe<T>& key) { return t < key.time; });
+		m_keys.insert(at, Keyframe<T>{ time, value });
+	}
+
+	/**
+	 * @brief The value of the track at the given time. Times outside the keys clamp to the
+	 * first or last key. The track must not be empty.
+	 */
+	T sample(float_t time) const {
+		if (time <= m_keys.front().time) {
+			return m_keys.front().value;
+		}
+		if (time >= m_keys.back().time) {
+			return m_keys.back().value;
+		}
+		// The first key strictly after time; the key before it starts the active interval.
+		auto next = std::upper_bound(m_keys.begin(), m_keys.end(), time,
+			[](float_t t, const Keyframe<T>& key) { return t < key.time; });
+		size_t i1 = next - m_keys.begin();
+		size_t i0 = i1 - 1;
+		const auto& k0 = m_keys[i0];
+		const auto& k1 = m_keys[i1];
+		float_t span = k1.time - k0.time;
+		float_t t = (time - k0.time) / span;
+
+		switch (m_interpolation) {
+		case Interpolation::Step:
+			return k0.value;
+		case Interpolation::Cubic:
+			return interpolateCubic(k0.value, tangent(i0) * span, k1.value, tangent(i1) * span, t);
+		case Interpolation::Linear:
+		default:
+			return interpolateLinear(k0.value, k1.value, t);
+		}
+	}
+};
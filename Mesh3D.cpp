@@ -1,5 +1,7 @@
 #include <iostream>
+#include <limits>
 #include "Mesh3D.h"
+#include "MeshOptimizer.h"
 #include <glad/glad.h>
 #include <GL/GL.h>
 
@@ -9,13 +11,48 @@ using sf::Vector2u;
 using glm::mat4;
 using glm::vec4;
 
+// The largest error, as a fraction of the viewport's height, a level of detail may show on
+// screen: about a pixel.
+const float_t MAX_SCREEN_ERROR = 0.001f;
+// How far past a level's threshold the projected size must go before the level changes.
+const float_t LOD_HYSTERESIS = 0.15f;
+
+static std::vector<MeshLevel> singleLevel(std::vector<uint32_t>&& faces) {
+	std::vector<MeshLevel> levels;
+	levels.push_back(MeshLevel{ std::move(faces), 0 });
+	return levels;
+}
+
 Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
 	Texture texture) 
 	: Mesh3D(std::move(vertices), std::move(faces), std::vector<Texture>{texture}) {
 }
 
 Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces, std::vector<Texture>&& textures)
- : m_vertexCount(vertices.size()), m_faceCount(faces.size()), m_textures(textures) {
+	: Mesh3D(std::move(vertices), singleLevel(std::move(faces)), std::move(textures)) {
+}
+
+Mesh3D::Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<MeshLevel>&& levels, std::vector<Texture>&& textures)
+ : m_vertexCount(vertices.size()), m_textures(textures), m_lod(0) {
+
+	m_optimizationStats = optimizeMesh(vertices, levels);
+	for (auto& v : vertices) {
+		m_bounds.expand(glm::vec3(v.x, v.y, v.z));
+	}
+
+	// All levels share one index buffer. A level may be drawn while its error, seen at the mesh's
+	// size on screen, stays under MAX_SCREEN_ERROR; at projected size s the error e covers
+	// e * s / (2 * radius) of the viewport.
+	float_t radius = glm::length(m_bounds.extents());
+	std::vector<uint32_t> faces;
+	for (auto& level : levels) {
+		float_t screenSize = level.error > 0
+			? 2 * MAX_SCREEN_ERROR * radius / level.error
+			: std::numeric_limits<float_t>::infinity();
+		m_lods.push_back(Lod{ static_cast<uint32_t>(faces.size()), static_cast<uint32_t>(level.faces.size()),
+			m_lods.empty() ? std::numeric_limits<float_t>::infinity() : screenSize });
+		faces.insert(faces.end(), level.faces.begin(), level.faces.end());
+	}
 
 	// Generate a vertex array object on the GPU.
 	glGenVertexArrays(1, &m_vao);
@@ -60,7 +97,37 @@ void Mesh3D::addTexture(Texture texture)
 	m_textures.push_back(texture);
 }
 
-void Mesh3D::render(sf::RenderWindow& window, ShaderProgram& program) const {
+const BoundingBox& Mesh3D::getBounds() const {
+	return m_bounds;
+}
+
+const TriangleBVH* Mesh3D::getTriangles() const {
+	return m_triangles.get();
+}
+
+void Mesh3D::setTriangles(std::shared_ptr<const TriangleBVH> triangles) {
+	m_triangles = std::move(triangles);
+}
+
+const MeshOptimizationStats& Mesh3D::getOptimizationStats() const {
+	return m_optimizationStats;
+}
+
+size_t Mesh3D::getLodCount() const {
+	return m_lods.size();
+}
+
+uint32_t Mesh3D::selectLod(float_t screenSize) const {
+	while (m_lod + 1 < m_lods.size() && screenSize < m_lods[m_lod + 1].screenSize * (1 - LOD_HYSTERESIS)) {
+		m_lod++;
+	}
+	while (m_lod > 0 && screenSize > m_lods[m_lod].screenSize * (1 + LOD_HYSTERESIS)) {
+		m_lod--;
+	}
+	return m_lod;
+}
+
+void Mesh3D::render(sf::RenderWindow& window, ShaderProgram& program, uint32_t lod) const {
 	// Activate the mesh's vertex array.
 	glBindVertexArray(m_vao);
 	for (auto i = 0; i < m_textures.size(); i++) {
@@ -70,7 +137,9 @@ void Mesh3D::render(sf::RenderWindow& window, ShaderProgram& program) const {
 	}
 
 	// Draw the vertex array, using its "element buffer" to identify the faces.
-	glDrawElements(GL_TRIANGLES, m_faceCount, GL_UNSIGNED_INT, nullptr);
+	const Lod& level = m_lods[lod];
+	glDrawElements(GL_TRIANGLES, level.indexCount, GL_UNSIGNED_INT,
+		reinterpret_cast<void*>(level.firstIndex * sizeof(uint32_t)));
 	// Deactivate the mesh's vertex array and texture.
 	glBindVertexArray(0);
 	glBindTexture(GL_TEXTURE_2D, 0);
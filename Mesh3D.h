@@ -4,6 +4,9 @@
 #include <glad/glad.h>
 #include "ShaderProgram.h"
 #include "Texture.h"
+#include "BoundingBox.h"
+#include "TriangleBVH.h"
+#include <memory>
 
 struct Vertex3D {
 	float_t x;
@@ -22,6 +25,56 @@ struct Vertex3D {
 		x(px), y(py), z(pz), nx(normX), ny(normY), nz(normZ), u(texU), v(texV) {}
 };
 
+/**
+ * @brief The faces of one level of detail of a mesh, and how far, in the mesh's units, its
+ * surface strays from the full-detail mesh.
+ */
+struct MeshLevel {
+	std::vector<uint32_t> faces;
+	float_t error;
+};
+
+/**
+ * @brief How often drawing a triangle list runs the vertex shader, given a post-transform cache.
+ * ACMR is vertex shader runs per triangle: 3 with no reuse, about 0.5 at best on a large regular
+ * mesh. ATVR is runs per distinct vertex used: 1 at best.
+ */
+struct VertexCacheStats {
+	size_t triangles = 0;
+	size_t vertices = 0;
+	size_t transforms = 0;
+
+	float_t acmr() const {
+		return triangles > 0 ? static_cast<float_t>(transforms) / triangles : 0;
+	}
+
+	float_t atvr() const {
+		return vertices > 0 ? static_cast<float_t>(transforms) / vertices : 0;
+	}
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other) {
+		triangles += other.triangles;
+		vertices += other.vertices;
+		transforms += other.transforms;
+		return *this;
+	}
+};
+
+/**
+ * @brief A mesh's vertex cache statistics before and after its triangles and vertices were
+ * reordered.
+ */
+struct MeshOptimizationStats {
+	VertexCacheStats before;
+	VertexCacheStats after;
+
+	MeshOptimizationStats& operator+=(const MeshOptimizationStats& other) {
+		before += other.before;
+		after += other.after;
+		return *this;
+	}
+};
+
 /**
  * @brief Represents a mesh whose vertices have positions, normal vectors, and texture coordinates;
  * as well as a list of Textures to bind when rendering the mesh.
@@ -31,7 +84,23 @@ private:
 	uint32_t m_vao;
 	std::vector<Texture> m_textures;
 	size_t m_vertexCount;
-	size_t m_faceCount;
+	// One range of the index buffer per level of detail, finest first, and the projected size
+	// below which each may be drawn.
+	struct Lod {
+		uint32_t firstIndex;
+		uint32_t indexCount;
+		float_t screenSize;
+	};
+	std::vector<Lod> m_lods;
+	// The level selectLod last chose. Each copy of the mesh chooses its own.
+	mutable uint32_t m_lod;
+	// The bounds of the mesh's vertices, in the mesh's local space.
+	BoundingBox m_bounds;
+	// How much reordering the mesh for the vertex cache saved.
+	MeshOptimizationStats m_optimizationStats;
+	// A CPU copy of the mesh's triangles, in local space, for exact ray tests; null unless kept.
+	// Copies of the mesh share it.
+	std::shared_ptr<const TriangleBVH> m_triangles;
 
 public:
 	Mesh3D() = delete;
@@ -46,8 +115,42 @@ public:
 	Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<uint32_t>&& faces,
 		std::vector<Texture>&& textures);
 
+	/**
+	 * @brief Constructs a Mesh3D with levels of detail, finest first, all indexing the same
+	 * vertices. The first level is drawn up close. Every mesh's triangles and vertices are
+	 * reordered for the GPU's vertex cache and for overdraw before they are uploaded.
+	 */
+	Mesh3D(std::vector<Vertex3D>&& vertices, std::vector<MeshLevel>&& levels,
+		std::vector<Texture>&& textures);
+
 	void addTexture(Texture texture);
 
+	/**
+	 * @brief Gets the bounding box of the mesh's vertices, in the mesh's local space.
+	 */
+	const BoundingBox& getBounds() const;
+
+	/**
+	 * @brief Gets the mesh's triangles in local space, or nullptr if they were not kept.
+	 */
+	const TriangleBVH* getTriangles() const;
+	void setTriangles(std::shared_ptr<const TriangleBVH> triangles);
+
+	/**
+	 * @brief Gets the vertex cache statistics of all the mesh's levels, before and after they
+	 * were reordered.
+	 */
+	const MeshOptimizationStats& getOptimizationStats() const;
+
+	size_t getLodCount() const;
+	/**
+	 * @brief Chooses the level of detail to draw, given the mesh's projected size: its bounding
+	 * radius over its distance, scaled by the projection, about its height as a fraction of the
+	 * viewport. The level changes only once the size is well past a level's threshold, so a
+	 * mesh lingering near one does not flicker between levels.
+	 */
+	uint32_t selectLod(float_t screenSize) const;
+
 	/**
 	 * @brief Constructs a 1x1 square centered at the origin in world space.
 	*/
@@ -62,8 +165,8 @@ public:
 	static Mesh3D triangle(const std::vector<Texture>& textures);
 
 	/**
-	 * @brief Renders the mesh to the given context.
+	 * @brief Renders the mesh, at the given level of detail, to the given context.
 	 */
-	void render(sf::RenderWindow& window, ShaderProgram& program) const;
+	void render(sf::RenderWindow& window, ShaderProgram& program, uint32_t lod = 0) const;
 	
 };
@@ -0,0 +1,300 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+
+namespace {
+	// The post-transform cache simulated while reordering and measuring: small enough that the
+	// order suits the caches of any desktop GPU.
+	const uint32_t VERTEX_CACHE_SIZE = 16;
+	// A cluster is cut wherever the cache misses of the part before the cut are within this
+	// factor of the whole cluster's, so sorting clusters for overdraw costs little cache reuse.
+	const float_t OVERDRAW_THRESHOLD = 1.05f;
+
+	/**
+	 * @brief A FIFO post-transform cache, kept as the time each vertex last entered it, so that
+	 * flushing is just moving the clock past every entry.
+	 */
+	struct CacheSimulator {
+		std::vector<uint32_t> stamps;
+		uint32_t time;
+
+		explicit CacheSimulator(size_t vertexCount) : stamps(vertexCount, 0), time(VERTEX_CACHE_SIZE + 1) {
+		}
+
+		bool contains(uint32_t vertex) const {
+			return time - stamps[vertex] <= VERTEX_CACHE_SIZE;
+		}
+
+		/**
+		 * @brief Looks the vertex up, adding it if it missed. Returns whether it missed.
+		 */
+		bool fetch(uint32_t vertex) {
+			if (contains(vertex)) {
+				return false;
+			}
+			stamps[vertex] = time++;
+			return true;
+		}
+
+		void flush() {
+			time += VERTEX_CACHE_SIZE + 1;
+		}
+	};
+
+	/**
+	 * @brief Tipsify: fans out the triangles around one vertex at a time, choosing next the
+	 * vertex that will still be in the cache after its own fan. Returns the reordered faces, and
+	 * the triangle each cluster starts at: wherever the walk hit a dead end and jumped elsewhere.
+	 */
+	std::vector<uint32_t> tipsify(const std::vector<uint32_t>& faces, size_t vertexCount,
+		std::vector<size_t>& clusters) {
+		size_t triangleCount = faces.size() / 3;
+
+		// The triangles using each vertex, and how many of them are not yet emitted.
+		std::vector<uint32_t> live(vertexCount, 0);
+		for (uint32_t index : faces) {
+			live[index]++;
+		}
+		std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++) {
+			firstTriangle[v + 1] = firstTriangle[v] + live[v];
+		}
+		std::vector<uint32_t> adjacency(faces.size());
+		std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < faces.size(); i++) {
+			adjacency[filled[faces[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		std::vector<uint32_t> result;
+		result.reserve(faces.size());
+		std::vector<bool> emitted(triangleCount, false);
+		CacheSimulator cache(vertexCount);
+		// Vertices of emitted triangles, most recent last, to restart from at a dead end.
+		std::vector<uint32_t> deadEnds;
+		std::vector<uint32_t> candidates;
+		size_t cursor = 0;
+		int64_t fan = 0;
+		clusters.assign(1, 0);
+		while (fan >= 0) {
+			candidates.clear();
+			for (uint32_t a = firstTriangle[fan]; a < firstTriangle[fan + 1]; a++) {
+				uint32_t triangle = adjacency[a];
+				if (emitted[triangle]) {
+					continue;
+				}
+				for (size_t c = 0; c < 3; c++) {
+					uint32_t v = faces[triangle * 3 + c];
+					result.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					live[v]--;
+					cache.fetch(v);
+				}
+				emitted[triangle] = true;
+			}
+
+			// The next fan: the candidate that entered the cache earliest, among those that will
+			// still be in it once their remaining triangles are emitted.
+			int64_t next = -1;
+			int64_t best = -1;
+			for (uint32_t v : candidates) {
+				if (live[v] == 0) {
+					continue;
+				}
+				int64_t priority = 0;
+				if (cache.time - cache.stamps[v] + 2 * live[v] <= VERTEX_CACHE_SIZE) {
+					priority = cache.time - cache.stamps[v];
+				}
+				if (priority > best) {
+					best = priority;
+					next = v;
+				}
+			}
+			if (next < 0) {
+				while (!deadEnds.empty() && next < 0) {
+					uint32_t v = deadEnds.back();
+					deadEnds.pop_back();
+					if (live[v] > 0) {
+						next = v;
+					}
+				}
+				while (next < 0 && cursor < vertexCount) {
+					if (live[cursor] > 0) {
+						next = static_cast<int64_t>(cursor);
+					}
+					cursor++;
+				}
+				if (next >= 0 && result.size() / 3 > clusters.back()) {
+					clusters.push_back(result.size() / 3);
+				}
+			}
+			fan = next;
+		}
+		return result;
+	}
+
+	/**
+	 * @brief Cuts each cluster wherever the triangles since the last cut, drawn from a cold
+	 * cache, miss no more than OVERDRAW_THRESHOLD times the whole cluster's rate.
+	 */
+	std::vector<size_t> softClusters(const std::vector<uint32_t>& faces, size_t vertexCount,
+		const std::vector<size_t>& clusters) {
+		size_t triangleCount = faces.size() / 3;
+		std::vector<size_t> result;
+		CacheSimulator cache(vertexCount);
+		for (size_t c = 0; c < clusters.size(); c++) {
+			size_t start = clusters[c];
+			size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+			cache.flush();
+			size_t misses = 0;
+			for (size_t i = start * 3; i < end * 3; i++) {
+				misses += cache.fetch(faces[i]);
+			}
+			float_t threshold = OVERDRAW_THRESHOLD * misses / (end - start);
+
+			result.push_back(start);
+			cache.flush();
+			misses = 0;
+			size_t count = 0;
+			for (size_t t = start; t < end; t++) {
+				for (size_t i = t * 3; i < t * 3 + 3; i++) {
+					misses += cache.fetch(faces[i]);
+				}
+				count++;
+				if (t + 1 < end && misses <= threshold * count) {
+					result.push_back(t + 1);
+					cache.flush();
+					misses = 0;
+					count = 0;
+				}
+			}
+		}
+		return result;
+	}
+
+	/**
+	 * @brief Sorts the clusters by how far their surface faces away from the mesh's centre: such
+	 * clusters are on the outside of the mesh, and drawing them first lets the depth test reject
+	 * more of the rest, from most points of view.
+	 */
+	std::vector<uint32_t> sortClusters(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& faces,
+		const std::vector<size_t>& clusters) {
+		size_t triangleCount = faces.size() / 3;
+		std::vector<glm::vec3> centroids(clusters.size(), glm::vec3(0));
+		std::vector<glm::vec3> normals(clusters.size(), glm::vec3(0));
+		std::vector<float_t> areas(clusters.size(), 0);
+		glm::vec3 meshCentroid(0);
+		float_t meshArea = 0;
+		for (size_t c = 0; c < clusters.size(); c++) {
+			size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+			for (size_t t = clusters[c]; t < end; t++) {
+				const glm::vec3& a = positions[faces[t * 3]];
+				const glm::vec3& b = positions[faces[t * 3 + 1]];
+				const glm::vec3& d = positions[faces[t * 3 + 2]];
+				// Twice the triangle's area, along its normal.
+				glm::vec3 normal = glm::cross(b - a, d - a);
+				float_t area = glm::length(normal);
+				centroids[c] = centroids[c] + (a + b + d) * (area / 3);
+				normals[c] = normals[c] + normal;
+				areas[c] += area;
+			}
+			meshCentroid = meshCentroid + centroids[c];
+			meshArea += areas[c];
+		}
+		if (meshArea > 0) {
+			meshCentroid = meshCentroid * (1 / meshArea);
+		}
+
+		std::vector<float_t> keys(clusters.size(), 0);
+		for (size_t c = 0; c < clusters.size(); c++) {
+			float_t length = glm::length(normals[c]);
+			if (areas[c] > 0 && length > 0) {
+				keys[c] = glm::dot(centroids[c] * (1 / areas[c]) - meshCentroid, normals[c] * (1 / length));
+			}
+		}
+		std::vector<size_t> order(clusters.size());
+		for (size_t c = 0; c < order.size(); c++) {
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+		std::vector<uint32_t> result;
+		result.reserve(faces.size());
+		for (size_t c : order) {
+			size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+			result.insert(result.end(), faces.begin() + clusters[c] * 3, faces.begin() + end * 3);
+		}
+		return result;
+	}
+}
+
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& faces, size_t vertexCount) {
+	VertexCacheStats stats;
+	stats.triangles = faces.size() / 3;
+	CacheSimulator cache(vertexCount);
+	std::vector<bool> used(vertexCount, false);
+	for (uint32_t index : faces) {
+		stats.transforms += cache.fetch(index);
+		if (!used[index]) {
+			used[index] = true;
+			stats.vertices++;
+		}
+	}
+	return stats;
+}
+
+void optimizeTriangleOrder(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& faces) {
+	if (faces.size() < 6) {
+		return;
+	}
+	std::vector<size_t> clusters;
+	faces = tipsify(faces, positions.size(), clusters);
+	faces = sortClusters(positions, faces, softClusters(faces, positions.size(), clusters));
+}
+
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& faces, size_t vertexCount) {
+	const uint32_t unassigned = static_cast<uint32_t>(-1);
+	std::vector<uint32_t> remap(vertexCount, unassigned);
+	std::vector<uint32_t> order;
+	order.reserve(vertexCount);
+	for (uint32_t& index : faces) {
+		if (remap[index] == unassigned) {
+			remap[index] = static_cast<uint32_t>(order.size());
+			order.push_back(index);
+		}
+		index = remap[index];
+	}
+	for (uint32_t v = 0; v < vertexCount; v++) {
+		if (remap[v] == unassigned) {
+			order.push_back(v);
+		}
+	}
+	return order;
+}
+
+MeshOptimizationStats optimizeMesh(std::vector<Vertex3D>& vertices, std::vector<MeshLevel>& levels) {
+	MeshOptimizationStats stats;
+	std::vector<glm::vec3> positions;
+	positions.reserve(vertices.size());
+	for (auto& v : vertices) {
+		positions.emplace_back(v.x, v.y, v.z);
+	}
+
+	std::vector<uint32_t> faces;
+	for (auto& level : levels) {
+		stats.before += analyzeVertexCache(level.faces, vertices.size());
+		optimizeTriangleOrder(positions, level.faces);
+		faces.insert(faces.end(), level.faces.begin(), level.faces.end());
+	}
+
+	// Renumber all levels together, finest first, so the finest reads the buffer in order.
+	auto order = optimizeVertexFetch(faces, vertices.size());
+	reorderVertices(vertices, order);
+	size_t offset = 0;
+	for (auto& level : levels) {
+		std::copy(faces.begin() + offset, faces.begin() + offset + level.faces.size(), level.faces.begin());
+		offset += level.faces.size();
+		stats.after += analyzeVertexCache(level.faces, vertices.size());
+	}
+	return stats;
+}
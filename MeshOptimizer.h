@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "Mesh3D.h"
+
+/**
+ * @brief Measures how often a triangle list runs the vertex shader, by simulating a FIFO
+ * post-transform cache of VERTEX_CACHE_SIZE vertices.
+ */
+VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& faces, size_t vertexCount);
+
+/**
+ * @brief Reorders triangles for the post-transform cache, then for overdraw (Sander, Nehab and
+ * Barczak's Tipsify). Triangles are first fanned around vertices still in the cache; the result
+ * is cut into clusters wherever a cut costs little cache reuse, and the clusters are sorted so
+ * those facing away from the mesh's centre, which tend to hide the rest, are drawn first.
+ */
+void optimizeTriangleOrder(const std::vector<glm::vec3>& positions, std::vector<uint32_t>& faces);
+
+/**
+ * @brief Renumbers vertices in the order the faces first use them, so the vertex shader reads
+ * the vertex buffer front to back. Rewrites the faces, and returns the old index of each new
+ * vertex for reorderVertices. Vertices no face uses keep their relative order at the end.
+ */
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& faces, size_t vertexCount);
+
+/**
+ * @brief Puts the vertices in the order optimizeVertexFetch chose.
+ */
+template <typename Vertex>
+void reorderVertices(std::vector<Vertex>& vertices, const std::vector<uint32_t>& order) {
+	std::vector<Vertex> reordered;
+	reordered.reserve(vertices.size());
+	for (uint32_t old : order) {
+		reordered.push_back(vertices[old]);
+	}
+	vertices.swap(reordered);
+}
+
+/**
+ * @brief Optimizes each level of detail's triangle order, then the order of the vertices they
+ * share, favouring the finest level. Returns the cache statistics of all levels together, before
+ * and after.
+ */
+MeshOptimizationStats optimizeMesh(std::vector<Vertex3D>& vertices, std::vector<MeshLevel>& levels);
@@ -0,0 +1,349 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace {
+	// A collapse may not turn a remaining triangle further than this from its old facing (the
+	// cosine of the angle), which would fold the surface over itself.
+	const float_t MAX_FLIP_COSINE = 0.2f;
+	// Borders resist moving away from themselves this much more than surfaces do.
+	const double BORDER_WEIGHT = 10;
+
+	/**
+	 * @brief The sum of the squared distances from a point to a set of weighted planes, as the
+	 * upper half of a symmetric 4x4 matrix, and the planes' total weight.
+	 */
+	struct Quadric {
+		double xx = 0, xy = 0, xz = 0, xw = 0, yy = 0, yz = 0, yw = 0, zz = 0, zw = 0, ww = 0;
+		double weight = 0;
+
+		static Quadric plane(const glm::vec3& normal, const glm::vec3& point, double weight) {
+			double a = normal.x, b = normal.y, c = normal.z;
+			double d = -(a * point.x + b * point.y + c * point.z);
+			Quadric q;
+			q.xx = a * a * weight; q.xy = a * b * weight; q.xz = a * c * weight; q.xw = a * d * weight;
+			q.yy = b * b * weight; q.yz = b * c * weight; q.yw = b * d * weight;
+			q.zz = c * c * weight; q.zw = c * d * weight;
+			q.ww = d * d * weight;
+			q.weight = weight;
+			return q;
+		}
+
+		void add(const Quadric& q) {
+			xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+			yy += q.yy; yz += q.yz; yw += q.yw;
+			zz += q.zz; zw += q.zw;
+			ww += q.ww;
+			weight += q.weight;
+		}
+
+		/**
+		 * @brief The weighted mean of the squared distances from the point to the planes.
+		 */
+		double error(const glm::vec3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double sum = xx * x * x + yy * y * y + zz * z * z + ww
+				+ 2 * (xy * x * y + xz * x * z + yz * y * z + xw * x + yw * y + zw * z);
+			return weight > 0 ? std::max(sum / weight, 0.0) : 0;
+		}
+	};
+
+	// How freely a position may move: ordered so a collapse may only move a position onto one
+	// at least as constrained as itself.
+	enum class VertexKind : uint8_t {
+		Manifold,
+		// Several vertices share the position with different normals or texture coordinates.
+		Seam,
+		// The position lies on an open edge of the surface.
+		Border,
+		// The position may not move at all.
+		Locked
+	};
+
+	struct Collapse {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromVersion;
+		uint32_t toVersion;
+
+		bool operator>(const Collapse& other) const {
+			return cost > other.cost;
+		}
+	};
+
+	glm::vec3 positionOf(const Vertex3D& v) {
+		return glm::vec3(v.x, v.y, v.z);
+	}
+
+	float_t attributeDistance(const Vertex3D& a, const Vertex3D& b) {
+		float_t nx = a.nx - b.nx, ny = a.ny - b.ny, nz = a.nz - b.nz, u = a.u - b.u, v = a.v - b.v;
+		return nx * nx + ny * ny + nz * nz + u * u + v * v;
+	}
+}
+
+std::vector<MeshLevel> simplifyMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& faces,
+	const std::vector<size_t>& targetTriangles, float_t maxError, const std::vector<bool>& locked) {
+	std::vector<MeshLevel> levels;
+	size_t triangleCount = faces.size() / 3;
+	if (triangleCount == 0 || targetTriangles.empty()) {
+		return levels;
+	}
+
+	// Weld vertices at the same position: the collapse works on positions, and each position
+	// keeps the list of vertices ("wedges") that share it.
+	std::vector<uint32_t> byPosition(vertices.size());
+	for (uint32_t i = 0; i < vertices.size(); i++) {
+		byPosition[i] = i;
+	}
+	auto lessPosition = [&vertices](uint32_t a, uint32_t b) {
+		const Vertex3D& va = vertices[a];
+		const Vertex3D& vb = vertices[b];
+		return va.x != vb.x ? va.x < vb.x : va.y != vb.y ? va.y < vb.y : va.z < vb.z;
+	};
+	std::sort(byPosition.begin(), byPosition.end(), lessPosition);
+	std::vector<uint32_t> positionOfVertex(vertices.size());
+	std::vector<glm::vec3> positions;
+	std::vector<std::vector<uint32_t>> wedges;
+	for (size_t i = 0; i < byPosition.size(); i++) {
+		if (i == 0 || lessPosition(byPosition[i - 1], byPosition[i])) {
+			positions.push_back(positionOf(vertices[byPosition[i]]));
+			wedges.emplace_back();
+		}
+		positionOfVertex[byPosition[i]] = static_cast<uint32_t>(positions.size() - 1);
+		wedges.back().push_back(byPosition[i]);
+	}
+	size_t positionCount = positions.size();
+
+	// The triangles over positions, which triangles use each position, and each position's
+	// quadric: the planes of the triangles around it, weighted by their areas.
+	std::vector<uint32_t> triangles(triangleCount * 3);
+	std::vector<bool> triangleAlive(triangleCount, true);
+	std::vector<std::vector<uint32_t>> around(positionCount);
+	std::vector<Quadric> quadrics(positionCount);
+	for (uint32_t t = 0; t < triangleCount; t++) {
+		for (size_t c = 0; c < 3; c++) {
+			triangles[t * 3 + c] = positionOfVertex[faces[t * 3 + c]];
+		}
+		uint32_t* tri = &triangles[t * 3];
+		if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0]) {
+			triangleAlive[t] = false;
+			triangleCount--;
+			continue;
+		}
+		glm::vec3 cross = glm::cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+		float_t length = glm::length(cross);
+		Quadric plane = length > 0
+			? Quadric::plane(cross / length, positions[tri[0]], length * 0.5)
+			: Quadric();
+		for (size_t c = 0; c < 3; c++) {
+			around[tri[c]].push_back(t);
+			quadrics[tri[c]].add(plane);
+		}
+	}
+
+	// An edge used by only one triangle is a border. Its positions also get the plane through the
+	// edge, perpendicular to the triangle, so collapses keep the border where it is.
+	std::vector<VertexKind> kinds(positionCount, VertexKind::Manifold);
+	for (size_t p = 0; p < positionCount; p++) {
+		if (wedges[p].size() > 1) {
+			kinds[p] = VertexKind::Seam;
+		}
+		for (uint32_t vertex : wedges[p]) {
+			if (vertex < locked.size() && locked[vertex]) {
+				kinds[p] = VertexKind::Locked;
+			}
+		}
+	}
+	for (uint32_t t = 0; t < triangles.size() / 3; t++) {
+		if (!triangleAlive[t]) {
+			continue;
+		}
+		for (size_t c = 0; c < 3; c++) {
+			uint32_t a = triangles[t * 3 + c];
+			uint32_t b = triangles[t * 3 + (c + 1) % 3];
+			size_t users = 0;
+			for (uint32_t other : around[a]) {
+				const uint32_t* tri = &triangles[other * 3];
+				if (triangleAlive[other] && (tri[0] == b || tri[1] == b || tri[2] == b)) {
+					users++;
+				}
+			}
+			if (users != 1) {
+				continue;
+			}
+			kinds[a] = std::max(kinds[a], VertexKind::Border);
+			kinds[b] = std::max(kinds[b], VertexKind::Border);
+			const uint32_t* tri = &triangles[t * 3];
+			glm::vec3 edge = positions[b] - positions[a];
+			glm::vec3 normal = glm::cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+			glm::vec3 perpendicular = glm::cross(edge, normal);
+			float_t length = glm::length(perpendicular);
+			if (length > 0) {
+				Quadric plane = Quadric::plane(perpendicular / length, positions[a],
+					glm::dot(edge, edge) * BORDER_WEIGHT);
+				quadrics[a].add(plane);
+				quadrics[b].add(plane);
+			}
+		}
+	}
+
+	// Collapses wait in a queue, cheapest first. A collapse is stale once either end has changed
+	// since it was queued; each position counts its changes.
+	std::vector<uint32_t> versions(positionCount, 0);
+	std::vector<uint32_t> collapsedInto(positionCount);
+	for (uint32_t p = 0; p < positionCount; p++) {
+		collapsedInto[p] = p;
+	}
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue;
+	auto queueEdge = [&](uint32_t a, uint32_t b) {
+		Quadric q = quadrics[a];
+		q.add(quadrics[b]);
+		bool aToB = kinds[a] != VertexKind::Locked && kinds[b] >= kinds[a];
+		bool bToA = kinds[b] != VertexKind::Locked && kinds[a] >= kinds[b];
+		double costAToB = aToB ? q.error(positions[b]) : HUGE_VAL;
+		double costBToA = bToA ? q.error(positions[a]) : HUGE_VAL;
+		if (costAToB <= costBToA) {
+			queue.push(Collapse{ costAToB, a, b, versions[a], versions[b] });
+		}
+		else {
+			queue.push(Collapse{ costBToA, b, a, versions[b], versions[a] });
+		}
+	};
+	std::vector<uint32_t> neighbours;
+	auto queueEdgesAround = [&](uint32_t p) {
+		neighbours.clear();
+		for (uint32_t t : around[p]) {
+			for (size_t c = 0; c < 3; c++) {
+				if (triangles[t * 3 + c] != p) {
+					neighbours.push_back(triangles[t * 3 + c]);
+				}
+			}
+		}
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		for (uint32_t other : neighbours) {
+			queueEdge(p, other);
+		}
+	};
+	for (uint32_t t = 0; t < triangles.size() / 3; t++) {
+		if (!triangleAlive[t]) {
+			continue;
+		}
+		for (size_t c = 0; c < 3; c++) {
+			uint32_t a = triangles[t * 3 + c];
+			uint32_t b = triangles[t * 3 + (c + 1) % 3];
+			if (a < b) {
+				queueEdge(a, b);
+			}
+		}
+	}
+
+	// A collapse is refused if it would fold or flatten one of the triangles that survive it.
+	auto keepsFacing = [&](uint32_t from, uint32_t to) {
+		for (uint32_t t : around[from]) {
+			const uint32_t* tri = &triangles[t * 3];
+			if (!triangleAlive[t] || tri[0] == to || tri[1] == to || tri[2] == to) {
+				continue;
+			}
+			glm::vec3 corners[3];
+			glm::vec3 moved[3];
+			for (size_t c = 0; c < 3; c++) {
+				corners[c] = positions[tri[c]];
+				moved[c] = tri[c] == from ? positions[to] : corners[c];
+			}
+			glm::vec3 before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+			if (glm::dot(before, after) <= MAX_FLIP_COSINE * glm::length(before) * glm::length(after)) {
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Each level's faces are the surviving triangles. A corner whose position collapsed takes the
+	// wedge of its new position with the closest normal and texture coordinates.
+	auto finalPosition = [&collapsedInto](uint32_t p) {
+		while (collapsedInto[p] != p) {
+			collapsedInto[p] = collapsedInto[collapsedInto[p]];
+			p = collapsedInto[p];
+		}
+		return p;
+	};
+	double worstError = 0;
+	auto recordLevel = [&]() {
+		MeshLevel level;
+		level.faces.reserve(triangleCount * 3);
+		for (uint32_t t = 0; t < triangles.size() / 3; t++) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+			for (size_t c = 0; c < 3; c++) {
+				uint32_t vertex = faces[t * 3 + c];
+				uint32_t position = finalPosition(positionOfVertex[vertex]);
+				if (position != positionOfVertex[vertex]) {
+					const auto& candidates = wedges[position];
+					vertex = *std::min_element(candidates.begin(), candidates.end(),
+						[&vertices, vertex](uint32_t a, uint32_t b) {
+							return attributeDistance(vertices[a], vertices[vertex])
+								< attributeDistance(vertices[b], vertices[vertex]);
+						});
+				}
+				level.faces.push_back(vertex);
+			}
+		}
+		level.error = static_cast<float_t>(std::sqrt(worstError));
+		levels.push_back(std::move(level));
+	};
+
+	size_t nextTarget = 0;
+	double maxCost = static_cast<double>(maxError) * maxError;
+	while (nextTarget < targetTriangles.size()) {
+		if (triangleCount <= targetTriangles[nextTarget]) {
+			recordLevel();
+			nextTarget++;
+			continue;
+		}
+		if (queue.empty() || queue.top().cost > maxCost) {
+			break;
+		}
+		Collapse collapse = queue.top();
+		queue.pop();
+		uint32_t from = collapse.from;
+		uint32_t to = collapse.to;
+		if (collapsedInto[from] != from || collapsedInto[to] != to || versions[from] != collapse.fromVersion
+			|| versions[to] != collapse.toVersion || !keepsFacing(from, to)) {
+			continue;
+		}
+
+		// Triangles on the edge vanish; the rest of from's triangles move to to.
+		for (uint32_t t : around[from]) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+			uint32_t* tri = &triangles[t * 3];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				triangleAlive[t] = false;
+				triangleCount--;
+				continue;
+			}
+			for (size_t c = 0; c < 3; c++) {
+				if (tri[c] == from) {
+					tri[c] = to;
+				}
+			}
+			around[to].push_back(t);
+		}
+		around[from].clear();
+		around[to].erase(std::remove_if(around[to].begin(), around[to].end(),
+			[&triangleAlive](uint32_t t) { return !triangleAlive[t]; }), around[to].end());
+		collapsedInto[from] = to;
+		quadrics[to].add(quadrics[from]);
+		versions[from]++;
+		versions[to]++;
+		worstError = std::max(worstError, collapse.cost);
+		queueEdgesAround(to);
+	}
+	return levels;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "Mesh3D.h"
+
+/**
+ * @brief Simplifies a mesh by quadric error edge collapse (Garland and Heckbert), recording a
+ * level each time the triangle count falls to one of the targets. Every collapse moves a vertex
+ * onto one of its neighbours, so the levels index the original vertices and can share their
+ * buffer.
+ *
+ * Vertices on an open border only collapse onto other border vertices, and vertices split by a
+ * normal or texture seam only onto other split vertices, so neither borders nor seams tear.
+ * Locked vertices never move, though others may collapse onto them.
+ * @param targetTriangles the triangle counts of the levels to record, largest first.
+ * @param maxError how far, in the mesh's units, the surface may stray from the original.
+ * Simplification stops before it strays further, so fewer levels than targets may be returned.
+ * @param locked for each vertex, whether it must stay where it is, such as on an edge the mesh
+ * shares with another mesh simplified separately. Empty if none are.
+ */
+std::vector<MeshLevel> simplifyMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& faces,
+	const std::vector<size_t>& targetTriangles, float_t maxError, const std::vector<bool>& locked = {});
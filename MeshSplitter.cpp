@@ -0,0 +1,217 @@
+#include "MeshSplitter.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+
+namespace {
+	/**
+	 * @brief A corner of a clipped polygon: a vertex of the mesh, or a point made by a cut.
+	 */
+	struct ClipVertex {
+		Vertex3D vertex;
+		// The mesh's index for the vertex, or -1 for a cut point.
+		int64_t original;
+	};
+
+	float_t& coordinate(Vertex3D& v, size_t axis) {
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+
+	float_t coordinate(const Vertex3D& v, size_t axis) {
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+
+	bool lessPosition(const Vertex3D& a, const Vertex3D& b) {
+		return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+	}
+
+	/**
+	 * @brief The point where the edge between a and b crosses the plane coordinate[axis] = value.
+	 * The endpoints are put in a fixed order first, so the two triangles sharing an edge make
+	 * exactly the same point.
+	 */
+	Vertex3D cut(const Vertex3D& a, const Vertex3D& b, size_t axis, float_t value) {
+		const Vertex3D& from = lessPosition(b, a) ? b : a;
+		const Vertex3D& to = lessPosition(b, a) ? a : b;
+		float_t t = (value - coordinate(from, axis)) / (coordinate(to, axis) - coordinate(from, axis));
+		auto lerp = [t](float_t p, float_t q) { return p + (q - p) * t; };
+		Vertex3D v(lerp(from.x, to.x), lerp(from.y, to.y), lerp(from.z, to.z), lerp(from.nx, to.nx),
+			lerp(from.ny, to.ny), lerp(from.nz, to.nz), lerp(from.u, to.u), lerp(from.v, to.v));
+		glm::vec3 normal(v.nx, v.ny, v.nz);
+		float_t length = glm::length(normal);
+		if (length > 0) {
+			v.nx /= length;
+			v.ny /= length;
+			v.nz /= length;
+		}
+		coordinate(v, axis) = value;
+		return v;
+	}
+
+	/**
+	 * @brief Clips the polygon to the side of the plane coordinate[axis] = value that is above
+	 * it, or below it (Sutherland and Hodgman). Corners on the plane are kept as they are.
+	 */
+	void clipPolygon(std::vector<ClipVertex>& polygon, size_t axis, float_t value, bool keepAbove,
+		std::vector<ClipVertex>& scratch) {
+		scratch.clear();
+		for (size_t i = 0; i < polygon.size(); i++) {
+			const ClipVertex& a = polygon[i];
+			const ClipVertex& b = polygon[(i + 1) % polygon.size()];
+			float_t da = coordinate(a.vertex, axis) - value;
+			float_t db = coordinate(b.vertex, axis) - value;
+			if (!keepAbove) {
+				da = -da;
+				db = -db;
+			}
+			if (da >= 0) {
+				scratch.push_back(a);
+			}
+			if ((da > 0 && db < 0) || (da < 0 && db > 0)) {
+				scratch.push_back(ClipVertex{ cut(a.vertex, b.vertex, axis, value), -1 });
+			}
+		}
+		polygon.swap(scratch);
+	}
+
+	/**
+	 * @brief Gathers one chunk, adding each vertex once: the mesh's vertices by index, and cut
+	 * points by value.
+	 */
+	struct ChunkBuilder {
+		MeshChunk chunk;
+		std::unordered_map<int64_t, uint32_t> originals;
+		std::map<std::array<float_t, 8>, uint32_t> cuts;
+
+		uint32_t add(const ClipVertex& corner) {
+			if (corner.original >= 0) {
+				auto found = originals.emplace(corner.original, static_cast<uint32_t>(chunk.vertices.size()));
+				if (found.second) {
+					chunk.vertices.push_back(corner.vertex);
+					chunk.locked.push_back(false);
+				}
+				return found.first->second;
+			}
+			const Vertex3D& v = corner.vertex;
+			std::array<float_t, 8> key{ v.x, v.y, v.z, v.nx, v.ny, v.nz, v.u, v.v };
+			auto found = cuts.emplace(key, static_cast<uint32_t>(chunk.vertices.size()));
+			if (found.second) {
+				chunk.vertices.push_back(v);
+				chunk.locked.push_back(true);
+			}
+			return found.first->second;
+		}
+
+		/**
+		 * @brief Adds the convex polygon as a fan of triangles, skipping any the clipping
+		 * collapsed to a line or point.
+		 */
+		void addPolygon(const std::vector<ClipVertex>& polygon) {
+			if (polygon.size() < 3) {
+				return;
+			}
+			uint32_t first = add(polygon[0]);
+			uint32_t previous = add(polygon[1]);
+			for (size_t i = 2; i < polygon.size(); i++) {
+				uint32_t current = add(polygon[i]);
+				if (first != previous && previous != current && current != first) {
+					chunk.faces.push_back(first);
+					chunk.faces.push_back(previous);
+					chunk.faces.push_back(current);
+				}
+				previous = current;
+			}
+		}
+	};
+}
+
+std::vector<MeshChunk> splitMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& faces,
+	float_t cellSize) {
+	BoundingBox bounds;
+	for (auto& v : vertices) {
+		bounds.expand(glm::vec3(v.x, v.y, v.z));
+	}
+	std::vector<MeshChunk> chunks;
+	if (bounds.isEmpty() || faces.empty()) {
+		return chunks;
+	}
+	glm::vec3 origin = bounds.min;
+	int64_t cellCounts[3];
+	for (size_t axis = 0; axis < 3; axis++) {
+		cellCounts[axis] = std::max<int64_t>(1,
+			static_cast<int64_t>(std::ceil((bounds.max[axis] - origin[axis]) / cellSize)));
+	}
+	auto cellOf = [&](float_t p, size_t axis) {
+		int64_t cell = static_cast<int64_t>(std::floor((p - origin[axis]) / cellSize));
+		return std::clamp<int64_t>(cell, 0, cellCounts[axis] - 1);
+	};
+
+	// Chunks by cell, in grid order.
+	std::map<int64_t, ChunkBuilder> builders;
+	auto builderFor = [&](const int64_t cell[3]) -> ChunkBuilder& {
+		return builders[(cell[2] * cellCounts[1] + cell[1]) * cellCounts[0] + cell[0]];
+	};
+
+	std::vector<ClipVertex> polygon;
+	std::vector<ClipVertex> scratch;
+	for (size_t f = 0; f + 2 < faces.size(); f += 3) {
+		ClipVertex corners[3] = {
+			ClipVertex{ vertices[faces[f]], faces[f] },
+			ClipVertex{ vertices[faces[f + 1]], faces[f + 1] },
+			ClipVertex{ vertices[faces[f + 2]], faces[f + 2] }
+		};
+		int64_t low[3];
+		int64_t high[3];
+		for (size_t axis = 0; axis < 3; axis++) {
+			low[axis] = high[axis] = cellOf(coordinate(corners[0].vertex, axis), axis);
+			for (size_t c = 1; c < 3; c++) {
+				int64_t cell = cellOf(coordinate(corners[c].vertex, axis), axis);
+				low[axis] = std::min(low[axis], cell);
+				high[axis] = std::max(high[axis], cell);
+			}
+		}
+
+		int64_t cell[3];
+		for (cell[2] = low[2]; cell[2] <= high[2]; cell[2]++) {
+			for (cell[1] = low[1]; cell[1] <= high[1]; cell[1]++) {
+				for (cell[0] = low[0]; cell[0] <= high[0]; cell[0]++) {
+					polygon.assign(corners, corners + 3);
+					// Only the cell's faces inside the triangle's range of cells can cut it.
+					for (size_t axis = 0; axis < 3 && polygon.size() >= 3; axis++) {
+						if (cell[axis] > low[axis]) {
+							clipPolygon(polygon, axis, origin[axis] + cell[axis] * cellSize, true, scratch);
+						}
+						if (cell[axis] < high[axis] && polygon.size() >= 3) {
+							clipPolygon(polygon, axis, origin[axis] + (cell[axis] + 1) * cellSize, false, scratch);
+						}
+					}
+					if (polygon.size() >= 3) {
+						builderFor(cell).addPolygon(polygon);
+					}
+				}
+			}
+		}
+	}
+
+	// A mesh vertex is on a seam if more than one chunk uses it; cut points always are.
+	std::vector<uint32_t> users(vertices.size(), 0);
+	for (auto& builder : builders) {
+		for (auto& original : builder.second.originals) {
+			users[original.first]++;
+		}
+	}
+	for (auto& builder : builders) {
+		if (builder.second.chunk.faces.empty()) {
+			continue;
+		}
+		for (auto& original : builder.second.originals) {
+			if (users[original.first] > 1) {
+				builder.second.chunk.locked[original.second] = true;
+			}
+		}
+		chunks.push_back(std::move(builder.second.chunk));
+	}
+	return chunks;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <vector>
+#include "Mesh3D.h"
+
+/**
+ * @brief One spatial piece of a split mesh: its own vertices and faces.
+ */
+struct MeshChunk {
+	std::vector<Vertex3D> vertices;
+	std::vector<uint32_t> faces;
+	// Whether each vertex is shared with a neighbouring chunk: a point made by a cut, or a mesh
+	// vertex that ended up in several chunks. Simplifying the chunk must not move these, or it
+	// would no longer meet its neighbours.
+	std::vector<bool> locked;
+};
+
+/**
+ * @brief Splits a mesh on a grid of cubes with the given edge length, starting at the mesh's
+ * minimum corner. A triangle inside one cube goes to that cube's chunk whole; a triangle
+ * crossing cubes is clipped to each, with normals and texture coordinates interpolated along
+ * the cut, so every chunk's bounds stay within its cube. Triangles on either side of a cut share
+ * the points the cut makes on their common edges, so the split leaves no cracks; the vertices
+ * along each cut are marked locked. Empty cubes make no chunks.
+ */
+std::vector<MeshChunk> splitMesh(const std::vector<Vertex3D>& vertices, const std::vector<uint32_t>& faces,
+	float_t cellSize);
@@ -1,18 +1,26 @@
 #include <glm/gtx/string_cast.hpp>
 #include <glm/ext.hpp>
 #include "Object3D.h"
+#include "RenderSnapshot.h"
 #include <iostream>
+#include <algorithm>
+#include <limits>
 
-void Object3D::rebuildModelMatrix() {
-	auto m = glm::translate(glm::mat4(1), m_position);
-	m = glm::translate(m, m_center * m_scale);
-	m = glm::rotate(m, m_orientation[2], glm::vec3(0, 0, 1));
-	m = glm::rotate(m, m_orientation[0], glm::vec3(1, 0, 0));
-	m = glm::rotate(m, m_orientation[1], glm::vec3(0, 1, 0));
-	m = glm::scale(m, m_scale);
+glm::mat4 Object3D::buildModelMatrix(const glm::vec3& position, const glm::vec3& orientation,
+	const glm::vec3& scale) const {
+	auto m = glm::translate(glm::mat4(1), position);
+	m = glm::translate(m, m_center * scale);
+	m = glm::rotate(m, orientation[2], glm::vec3(0, 0, 1));
+	m = glm::rotate(m, orientation[0], glm::vec3(1, 0, 0));
+	m = glm::rotate(m, orientation[1], glm::vec3(0, 1, 0));
+	m = glm::scale(m, scale);
 	m = glm::translate(m, -m_center);
-	m = m * m_baseTransform;
-	m_modelMatrix = m;
+	return m * m_baseTransform;
+}
+
+void Object3D::rebuildModelMatrix() {
+	m_modelMatrix = buildModelMatrix(m_position, m_orientation, m_scale);
+	m_interpolatedMatrix = m_modelMatrix;
 }
 
 Object3D::Object3D(std::vector<Mesh3D>&& meshes)
@@ -22,9 +30,10 @@ Object3D::Object3D(std::vector<Mesh3D>&& meshes)
 
 Object3D::Object3D(std::vector<Mesh3D>&& meshes, const glm::mat4& baseTransform)
 	: m_meshes(meshes), m_position(), m_orientation(), m_scale(1.0),
-	m_center(), m_baseTransform(baseTransform)
+	m_center(), m_baseTransform(baseTransform), m_renderedWorldMatrix(0), m_normalMatrix(1)
 {
 	rebuildModelMatrix();
+	savePreviousTransform();
 }
 
 const glm::vec3& Object3D::getPosition() const {
@@ -50,6 +59,84 @@ const std::string& Object3D::getName() const {
 	return m_name;
 }
 
+/**
+ * @brief Gets the world-space bounding box of the object and all of its children, treating this
+ * object as the root of its hierarchy.
+ */
+BoundingBox Object3D::getWorldBounds() const {
+	BoundingBox bounds;
+	accumulateBounds(bounds, glm::mat4(1));
+	return bounds;
+}
+
+void Object3D::accumulateBounds(BoundingBox& bounds, const glm::mat4& parentMatrix) const {
+	glm::mat4 trueModel = parentMatrix * m_modelMatrix;
+	for (auto& mesh : m_meshes) {
+		bounds.expand(mesh.getBounds().transformed(trueModel));
+	}
+	for (auto& child : m_children) {
+		child.accumulateBounds(bounds, trueModel);
+	}
+}
+
+bool Object3D::hasTriangles() const {
+	for (auto& mesh : m_meshes) {
+		if (mesh.getTriangles() != nullptr) {
+			return true;
+		}
+	}
+	for (auto& child : m_children) {
+		if (child.hasTriangles()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+MeshOptimizationStats Object3D::getOptimizationStats() const {
+	MeshOptimizationStats stats;
+	for (auto& mesh : m_meshes) {
+		stats += mesh.getOptimizationStats();
+	}
+	for (auto& child : m_children) {
+		stats += child.getOptimizationStats();
+	}
+	return stats;
+}
+
+bool Object3D::raycastTriangles(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+	float_t& distance) const {
+	distance = maxDistance;
+	return raycastTrianglesRecursive(origin, direction, distance, glm::mat4(1));
+}
+
+bool Object3D::raycastTrianglesRecursive(const glm::vec3& origin, const glm::vec3& direction, float_t& distance,
+	const glm::mat4& parentMatrix) const {
+	glm::mat4 trueModel = parentMatrix * m_modelMatrix;
+	// Cast in the object's local space. Scaling stretches the direction, so distances are
+	// converted by its local length.
+	glm::mat4 toLocal = glm::inverse(trueModel);
+	glm::vec3 localOrigin(toLocal * glm::vec4(origin, 1));
+	glm::vec3 localDirection(toLocal * glm::vec4(direction, 0));
+	float_t stretch = glm::length(localDirection);
+	bool found = false;
+	for (auto& mesh : m_meshes) {
+		const TriangleBVH* triangles = mesh.getTriangles();
+		if (triangles == nullptr || stretch == 0) {
+			continue;
+		}
+		CastHit hit;
+		if (triangles->raycast(localOrigin, localDirection / stretch, distance * stretch, hit)) {
+			distance = hit.distance / stretch;
+			found = true;
+		}
+	}
+	for (auto& child : m_children) {
+		found = child.raycastTrianglesRecursive(origin, direction, distance, trueModel) || found;
+	}
+	return found;
+}
+
 size_t Object3D::numberOfChildren() const {
 	return m_children.size();
 }
@@ -110,6 +197,39 @@ void Object3D::addChild(Object3D&& child)
 	m_children.emplace_back(child);
 }
 
+/**
+ * @brief Records the current transform of the object and its children as the previous step's,
+ * before the simulation advances them.
+ */
+void Object3D::savePreviousTransform() {
+	m_previousPosition = m_position;
+	m_previousOrientation = m_orientation;
+	m_previousScale = m_scale;
+	for (auto& child : m_children) {
+		child.savePreviousTransform();
+	}
+}
+
+/**
+ * @brief Draws the object and its children the given fraction of the way from their previous
+ * step's transform to their current one, so motion looks smooth between simulation steps.
+ */
+void Object3D::interpolateTransform(float_t alpha) {
+	m_interpolatedMatrix = buildModelMatrix(glm::mix(m_previousPosition, m_position, alpha),
+		glm::mix(m_previousOrientation, m_orientation, alpha), glm::mix(m_previousScale, m_scale, alpha));
+	for (auto& child : m_children) {
+		child.interpolateTransform(alpha);
+	}
+}
+
+/**
+ * @brief The position the object is drawn at when interpolated by the given fraction, for
+ * anything that must move with its mesh, such as a light it carries.
+ */
+glm::vec3 Object3D::getInterpolatedPosition(float_t alpha) const {
+	return glm::mix(m_previousPosition, m_position, alpha);
+}
+
 void Object3D::render(sf::RenderWindow& window, ShaderProgram& shaderProgram) const {
 	renderRecursive(window, shaderProgram, glm::mat4(1));
 }
@@ -120,8 +240,15 @@ void Object3D::render(sf::RenderWindow& window, ShaderProgram& shaderProgram) co
  */
 void Object3D::renderRecursive(sf::RenderWindow& window, ShaderProgram& shaderProgram, const glm::mat4& parentMatrix) const {
 	// This object's true model matrix is the combination of its parent's matrix and the object's matrix.
-	glm::mat4 trueModel = parentMatrix * m_modelMatrix;
+	glm::mat4 trueModel = parentMatrix * m_interpolatedMatrix;
+	// Normals transform by the inverse transpose of the model matrix. Inverting once per node here
+	// is far cheaper than inverting once per vertex in the vertex shader.
+	if (trueModel != m_renderedWorldMatrix) {
+		m_renderedWorldMatrix = trueModel;
+		m_normalMatrix = glm::transpose(glm::inverse(glm::mat3(trueModel)));
+	}
 	shaderProgram.setUniform("model", trueModel);
+	shaderProgram.setUniform("normalMatrix", m_normalMatrix);
 	// Render each mesh in the object.
 	for (auto& mesh : m_meshes) {
 		mesh.render(window, shaderProgram);
@@ -132,56 +259,41 @@ void Object3D::renderRecursive(sf::RenderWindow& window, ShaderProgram& shaderPr
 	}
 }
 
-void Object3D::tick(float_t dt) {
-	glm::vec3 acceleration (0.0f);
-	if (m_mass != 0) {
-		for (const auto& force : m_forces) {
-			sumForces += force;
-			acceleration = sumForces/m_mass;
+/**
+ * @brief Records the object and its children for drawing instead of drawing them now, so the
+ * draws can be replayed later, on another thread.
+ * @param draws the draw list to append to.
+ * @param parentMatrix the world matrix of the object's parent, or the identity for a root.
+ * @param view the viewer's position, frustum, projection scale and visible cells, which decide
+ * which meshes are kept, how they sort, and their levels of detail.
+ */
+void Object3D::addDrawItems(std::vector<DrawItem>& draws, const glm::mat4& parentMatrix, const DrawView& view) const {
+	glm::mat4 trueModel = parentMatrix * m_interpolatedMatrix;
+	if (trueModel != m_renderedWorldMatrix) {
+		m_renderedWorldMatrix = trueModel;
+		m_normalMatrix = glm::transpose(glm::inverse(glm::mat3(trueModel)));
+	}
+	float_t scale = std::max({ glm::length(glm::vec3(trueModel[0])), glm::length(glm::vec3(trueModel[1])),
+		glm::length(glm::vec3(trueModel[2])) });
+	for (auto& mesh : m_meshes) {
+		BoundingBox worldBounds = mesh.getBounds().transformed(trueModel);
+		if (view.frustum.test(worldBounds) == Frustum::Test::Outside
+			|| (view.cells != nullptr && !view.cells->test(worldBounds))) {
+			continue;
+		}
+		uint32_t lod = 0;
+		if (mesh.getLodCount() > 1) {
+			const BoundingBox& bounds = mesh.getBounds();
+			float_t radius = glm::length(bounds.extents()) * scale;
+			float_t distance = glm::length(glm::vec3(trueModel * glm::vec4(bounds.center(), 1)) - view.viewPos);
+			// Inside its bounding sphere, a mesh fills the screen.
+			float_t screenSize = distance > radius ? radius * view.projectionScale / distance
+				: std::numeric_limits<float_t>::max();
+			lod = mesh.selectLod(screenSize);
 		}
+		draws.push_back(DrawItem{ &mesh, trueModel, m_normalMatrix, worldBounds.distanceSquared(view.viewPos), lod });
 	}
-	
-	m_velocity +=  acceleration * dt;	
-	m_position += m_velocity * dt;
-
-	m_rotationalVelocity += m_rotationalAcceleration * dt; 
-	m_orientation += m_rotationalVelocity * dt;
-	rebuildModelMatrix();
-	sumForces=glm::vec3(0.0f);
-	for (auto& c : m_children) {
-		c.tick(dt);
+	for (auto& child : m_children) {
+		child.addDrawItems(draws, trueModel, view);
 	}
-	m_forces.clear();
-}
-
-
-
-void Object3D::setVelocity(const glm::vec3& velocity) {
-	m_velocity = velocity;
 }
-
-const glm::vec3& Object3D::getVelocity() const {
-	return m_velocity;
-}
-const float_t& Object3D::getMass() const {
-	return m_mass; 
-}
-void Object3D::setMass(const float_t& mass) {
-	m_mass = mass; 
-}
-void Object3D::setRotationalVelocity(const glm::vec3& rotationalVelocity) {
-	m_rotationalVelocity = rotationalVelocity;
-}
-const glm::vec3& Object3D::getRotationalVelocity() const {
-	return m_rotationalVelocity;
-}
-void Object3D::setRotationalAcceleration(const glm::vec3& rotationalAcceleration) {
-	m_rotationalAcceleration = rotationalAcceleration;
-}
-const glm::vec3& Object3D::getRotationalAcceleration() const {
-	return m_rotationalAcceleration;
-}
-void Object3D::addForce(const glm::vec3& force) { 
-	m_forces.push_back(force); 
-}
-
@@ -3,6 +3,10 @@
 #include <vector>
 #include "Mesh3D.h"
 #include "ShaderProgram.h"
+
+struct DrawItem;
+struct DrawView;
+
 /**
  * @brief Represents an object placed in a 3D scene. The object is a node in an hierarchy of
  * objects representing a single 3D model. Each object in the hierarchy has its own position,
@@ -10,15 +14,6 @@
 */
 class Object3D {
 private:
-	//Physics
-	float_t m_mass;
-	glm::vec3 sumForces;
-	//glm::vec3 acceleration;
-	glm::vec3 m_velocity;
-	std::vector<glm::vec3> m_forces;
-	glm::vec3 m_rotationalAcceleration;
-	glm::vec3 m_rotationalVelocity;
-
 	// The object's list of meshes and children.
 	std::vector<Mesh3D> m_meshes;
 	std::vector<Object3D> m_children;
@@ -33,11 +28,31 @@ private:
 	glm::mat4 m_modelMatrix;
 	glm::mat4 m_baseTransform;
 
+	// The object's transform at the previous simulation step, and the matrix it is drawn with:
+	// the model matrix, or a blend of the previous and current transforms.
+	glm::vec3 m_previousPosition;
+	glm::vec3 m_previousOrientation;
+	glm::vec3 m_previousScale;
+	glm::mat4 m_interpolatedMatrix;
+
+	// The world matrix this object was last rendered with, and the normal matrix (inverse
+	// transpose of its upper 3x3) derived from it. Only recomputed when the world matrix changes.
+	mutable glm::mat4 m_renderedWorldMatrix;
+	mutable glm::mat3 m_normalMatrix;
+
 	// Some objects from Assimp imports have a "name" field, useful for debugging.
 	std::string m_name;
 
 	// Recomputes the local->world transformation matrix.
 	void rebuildModelMatrix();
+	// Builds a local->world transformation matrix from the given transform.
+	glm::mat4 buildModelMatrix(const glm::vec3& position, const glm::vec3& orientation, const glm::vec3& scale) const;
+	// Grows the box by the world-space bounds of this object's meshes and children.
+	void accumulateBounds(BoundingBox& bounds, const glm::mat4& parentMatrix) const;
+	// Clips the ray's distance to the nearest hit on the kept triangles of this object's meshes
+	// and children.
+	bool raycastTrianglesRecursive(const glm::vec3& origin, const glm::vec3& direction, float_t& distance,
+		const glm::mat4& parentMatrix) const;
 
 public:
 
@@ -53,10 +68,15 @@ public:
 	const glm::vec3& getScale() const;
 	const glm::vec3& getCenter() const;
 	const std::string& getName() const;
-	const glm::vec3& getVelocity() const;
-	const glm::vec3& getRotationalVelocity() const;
-	const glm::vec3& getRotationalAcceleration() const;
-	const float_t& getMass() const;
+	BoundingBox getWorldBounds() const;
+	// Whether any mesh of the object or its children kept its triangles.
+	bool hasTriangles() const;
+	// The vertex cache statistics of the object's meshes and children, summed.
+	MeshOptimizationStats getOptimizationStats() const;
+	// Finds the nearest of the object's kept triangles hit by a ray with a unit direction, within
+	// maxDistance.
+	bool raycastTriangles(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+		float_t& distance) const;
 
 	// Child management.
 	size_t numberOfChildren() const;
@@ -69,23 +89,24 @@ public:
 	void setScale(const glm::vec3& scale);
 	void setCenter(const glm::vec3& center);
 	void setName(const std::string& name);
-	void setMass(const float_t& mass);
-	void setRotationalAcceleration(const glm::vec3& rotationalAcceleration);
-	void setRotationalVelocity(const glm::vec3& rotationalVelocity);
-	
+
 	// Transformations.
 	void move(const glm::vec3& offset);
 	void rotate(const glm::vec3& rotation);
 	void grow(const glm::vec3& growth);
 	void addChild(Object3D&& child);
 
+	// Interpolation between fixed simulation steps.
+	void savePreviousTransform();
+	void interpolateTransform(float_t alpha);
+	glm::vec3 getInterpolatedPosition(float_t alpha) const;
+
 	// Rendering.
 	void render(sf::RenderWindow& window, ShaderProgram& shaderProgram) const;
 	void renderRecursive(sf::RenderWindow& window, ShaderProgram& shaderProgram, const glm::mat4& parentMatrix) const;
-	
-	//Physics
-	void tick(float_t dt);
-	void setVelocity(const glm::vec3& velocity);
-	void addForce(const glm::vec3& force);
-	void decelerateRotation(float_t deceleration, float_t dt);
+	// Appends the meshes of the object and its children the viewer may see, with their world
+	// matrices, to a draw list. Each mesh is keyed by the distance to its bounds, so meshes the
+	// viewer stands inside (the sky, the level's chunk around it) come first and occlude what
+	// follows, and its level of detail is chosen by its size on screen.
+	void addDrawItems(std::vector<DrawItem>& draws, const glm::mat4& parentMatrix, const DrawView& view) const;
 };
\ No newline at end of file
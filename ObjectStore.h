@@ -0,0 +1,52 @@
+#pragma once
+#include <initializer_list>
+#include <vector>
+#include "Object3D.h"
+#include "SlotMap.h"
+
+/**
+ * @brief The root objects of a scene, addressed by stable handles.
+ */
+using ObjectStore = SlotMap<Object3D>;
+using ObjectHandle = ObjectStore::Handle;
+
+/**
+ * @brief Refers to an object in an ObjectStore: a root object by handle, then a path of child
+ * indices below it. Unlike an Object3D&, a reference survives the store growing, shrinking or
+ * moving; it is resolved against the store each time it is used, and resolves to nothing once
+ * its root has been erased.
+ */
+class ObjectRef {
+private:
+	ObjectHandle m_root;
+	std::vector<uint32_t> m_path;
+
+public:
+	ObjectRef(ObjectHandle root) : m_root(root) {}
+	ObjectRef(ObjectHandle root, std::initializer_list<uint32_t> path) : m_root(root), m_path(path) {}
+
+	/**
+	 * @brief A reference to the given child of this object.
+	 */
+	ObjectRef child(uint32_t index) const {
+		ObjectRef ref = *this;
+		ref.m_path.push_back(index);
+		return ref;
+	}
+
+	const ObjectHandle& root() const { return m_root; }
+
+	/**
+	 * @brief The referenced object, or nullptr if it no longer exists.
+	 */
+	Object3D* resolve(ObjectStore& objects) const {
+		Object3D* object = objects.get(m_root);
+		for (auto index : m_path) {
+			if (object == nullptr || index >= object->numberOfChildren()) {
+				return nullptr;
+			}
+			object = &object->getChild(index);
+		}
+		return object;
+	}
+};
@@ -10,6 +10,6 @@ private:
     }
 
 public:
-    PauseAnimation(Object3D& object, float_t duration) :
-        Animation(object, duration) {}
+    PauseAnimation(ObjectRef object, float_t duration) :
+        Animation(std::move(object), duration) {}
 };
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "PhysicsWorld.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	// Below this approach speed a contact is resting, and does not bounce. Otherwise gravity
+	// would keep a body at rest hopping by a fraction of a millimetre every step.
+	const float_t RESTING_SPEED = 0.5f;
+	// How far a swept body stops short of the surface it hits, so it starts the next sweep
+	// outside the surface rather than exactly on it.
+	const float_t SKIN = 1e-4f;
+}
+
+PhysicsWorld::PhysicsWorld(const glm::vec3& gravity, float_t cellSize)
+	: m_gravity(gravity), m_cellSize(cellSize), m_query(0) {
+}
+
+PhysicsWorld::BodyId PhysicsWorld::addSphere(const glm::vec3& position, float_t radius, float_t mass,
+	float_t restitution, float_t friction) {
+	BodyId body = static_cast<BodyId>(m_positions.size());
+	m_positions.push_back(position);
+	m_velocities.push_back(glm::vec3(0));
+	m_forces.push_back(glm::vec3(0));
+	m_inverseMasses.push_back(mass > 0 ? 1 / mass : 0);
+	m_radii.push_back(radius);
+	m_restitutions.push_back(restitution);
+	m_frictions.push_back(friction);
+	m_sweepOrder.push_back(body);
+	return body;
+}
+
+uint64_t PhysicsWorld::cellKey(int32_t x, int32_t z) const {
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+}
+
+void PhysicsWorld::addStaticBox(const BoundingBox& box) {
+	uint32_t index = static_cast<uint32_t>(m_staticBoxes.size());
+	m_staticBoxes.push_back(box);
+	m_boxVisits.push_back(0);
+	int32_t x0 = static_cast<int32_t>(std::floor(box.min.x / m_cellSize));
+	int32_t x1 = static_cast<int32_t>(std::floor(box.max.x / m_cellSize));
+	int32_t z0 = static_cast<int32_t>(std::floor(box.min.z / m_cellSize));
+	int32_t z1 = static_cast<int32_t>(std::floor(box.max.z / m_cellSize));
+	for (int32_t x = x0; x <= x1; x++) {
+		for (int32_t z = z0; z <= z1; z++) {
+			m_cells[cellKey(x, z)].push_back(index);
+		}
+	}
+}
+
+void PhysicsWorld::addStaticMesh(TriangleBVH&& mesh) {
+	if (!mesh.empty()) {
+		m_staticMeshes.push_back(std::move(mesh));
+	}
+}
+
+void PhysicsWorld::addStaticTriangles(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices) {
+	addStaticMesh(TriangleBVH::fromIndexed(vertices, indices));
+}
+
+size_t PhysicsWorld::bodyCount() const {
+	return m_positions.size();
+}
+
+const glm::vec3& PhysicsWorld::position(BodyId body) const {
+	return m_positions[body];
+}
+
+const glm::vec3& PhysicsWorld::velocity(BodyId body) const {
+	return m_velocities[body];
+}
+
+void PhysicsWorld::setPosition(BodyId body, const glm::vec3& position) {
+	m_positions[body] = position;
+}
+
+void PhysicsWorld::setVelocity(BodyId body, const glm::vec3& velocity) {
+	m_velocities[body] = velocity;
+}
+
+void PhysicsWorld::addForce(BodyId body, const glm::vec3& force) {
+	m_forces[body] += force;
+}
+
+void PhysicsWorld::step(float_t dt) {
+	integrate(dt);
+	collideStatic();
+	collideBodies();
+}
+
+void PhysicsWorld::queryStatic(const BoundingBox& region, std::vector<BoundingBox>& boxes,
+	std::vector<CollisionTriangle>& triangles) {
+	gatherStaticBoxes(region.min, region.max);
+	for (uint32_t index : m_candidates) {
+		if (m_staticBoxes[index].overlaps(region)) {
+			boxes.push_back(m_staticBoxes[index]);
+		}
+	}
+	for (auto& mesh : m_staticMeshes) {
+		m_triangles.clear();
+		mesh.overlapBox(region, m_triangles);
+		for (uint32_t index : m_triangles) {
+			triangles.push_back(mesh.triangles()[index]);
+		}
+	}
+}
+
+bool PhysicsWorld::raycastStatic(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+	CastHit& hit) const {
+	bool found = false;
+	for (auto& mesh : m_staticMeshes) {
+		// Each mesh only needs to beat the nearest hit so far.
+		if (mesh.raycast(origin, direction, found ? hit.distance : maxDistance, hit)) {
+			found = true;
+		}
+	}
+	return found;
+}
+
+void PhysicsWorld::integrate(float_t dt) {
+	size_t count = m_positions.size();
+	for (BodyId body = 0; body < count; body++) {
+		if (m_inverseMasses[body] == 0) {
+			continue;
+		}
+		// Semi-implicit Euler: the position moves by the updated velocity, which keeps orbits
+		// and bounces from gaining energy the way explicit Euler does.
+		m_velocities[body] += (m_gravity + m_forces[body] * m_inverseMasses[body]) * dt;
+		sweep(body, dt);
+	}
+	std::fill(m_forces.begin(), m_forces.end(), glm::vec3(0));
+}
+
+void PhysicsWorld::gatherStaticBoxes(const glm::vec3& min, const glm::vec3& max) {
+	m_candidates.clear();
+	m_query++;
+	int32_t x0 = static_cast<int32_t>(std::floor(min.x / m_cellSize));
+	int32_t x1 = static_cast<int32_t>(std::floor(max.x / m_cellSize));
+	int32_t z0 = static_cast<int32_t>(std::floor(min.z / m_cellSize));
+	int32_t z1 = static_cast<int32_t>(std::floor(max.z / m_cellSize));
+	for (int32_t x = x0; x <= x1; x++) {
+		for (int32_t z = z0; z <= z1; z++) {
+			auto cell = m_cells.find(cellKey(x, z));
+			if (cell == m_cells.end()) {
+				continue;
+			}
+			for (uint32_t box : cell->second) {
+				if (m_boxVisits[box] != m_query) {
+					m_boxVisits[box] = m_query;
+					m_candidates.push_back(box);
+				}
+			}
+		}
+	}
+}
+
+void PhysicsWorld::sweep(BodyId body, float_t dt) {
+	float_t radius = m_radii[body];
+	float_t remaining = dt;
+	for (uint32_t i = 0; i < MAX_SWEEPS && remaining > 0; i++) {
+		glm::vec3 start = m_positions[body];
+		glm::vec3 motion = m_velocities[body] * remaining;
+		gatherStaticBoxes(glm::min(start, start + motion) - radius, glm::max(start, start + motion) + radius);
+
+		// The earliest time of impact along the motion.
+		float_t first = 1;
+		glm::vec3 firstNormal(0);
+		for (uint32_t box : m_candidates) {
+			float_t fraction;
+			glm::vec3 normal;
+			if (sweepSphereBox(start, motion, radius, m_staticBoxes[box], fraction, normal) && fraction < first) {
+				first = fraction;
+				firstNormal = normal;
+			}
+		}
+		for (auto& mesh : m_staticMeshes) {
+			CastHit hit;
+			if (mesh.sphereCast(start, motion, radius, hit) && hit.distance < first) {
+				first = hit.distance;
+				firstNormal = hit.normal;
+			}
+		}
+		if (first >= 1) {
+			m_positions[body] = start + motion;
+			return;
+		}
+		// Advance to the surface, bounce, and spend the rest of the step on the new velocity.
+		m_positions[body] = start + motion * first + firstNormal * SKIN;
+		resolveStaticContact(body, firstNormal, 0);
+		remaining *= 1 - first;
+	}
+}
+
+void PhysicsWorld::resolveStaticContact(BodyId body, const glm::vec3& normal, float_t depth) {
+	m_positions[body] += normal * depth;
+	glm::vec3& v = m_velocities[body];
+	float_t approach = glm::dot(v, normal);
+	if (approach >= 0) {
+		return;
+	}
+	glm::vec3 sliding = v - normal * approach;
+	float_t bounce = -approach > RESTING_SPEED ? m_restitutions[body] : 0;
+	v = sliding * (1 - m_frictions[body]) - normal * (approach * bounce);
+}
+
+void PhysicsWorld::collideStatic() {
+	size_t count = m_positions.size();
+	for (BodyId body = 0; body < count; body++) {
+		if (m_inverseMasses[body] == 0) {
+			continue;
+		}
+		float_t radius = m_radii[body];
+		gatherStaticBoxes(m_positions[body] - radius, m_positions[body] + radius);
+		for (uint32_t index : m_candidates) {
+			// Earlier contacts in this loop may have moved the body.
+			const glm::vec3& center = m_positions[body];
+			const BoundingBox& box = m_staticBoxes[index];
+			glm::vec3 closest = glm::clamp(center, box.min, box.max);
+			glm::vec3 offset = center - closest;
+			float_t distance2 = glm::dot(offset, offset);
+			if (distance2 >= radius * radius) {
+				continue;
+			}
+			if (distance2 > 0) {
+				float_t distance = std::sqrt(distance2);
+				resolveStaticContact(body, offset / distance, radius - distance);
+			}
+			else {
+				// The center is inside the box: leave through the nearest face.
+				glm::vec3 toMin = center - box.min;
+				glm::vec3 toMax = box.max - center;
+				glm::vec3 normal(0);
+				float_t depth = std::numeric_limits<float_t>::max();
+				for (int32_t axis = 0; axis < 3; axis++) {
+					if (toMin[axis] < depth) {
+						depth = toMin[axis];
+						normal = glm::vec3(0);
+						normal[axis] = -1;
+					}
+					if (toMax[axis] < depth) {
+						depth = toMax[axis];
+						normal = glm::vec3(0);
+						normal[axis] = 1;
+					}
+				}
+				resolveStaticContact(body, normal, depth + radius);
+			}
+		}
+
+		for (auto& mesh : m_staticMeshes) {
+			m_triangles.clear();
+			mesh.overlapSphere(m_positions[body], radius, m_triangles);
+			for (uint32_t index : m_triangles) {
+				const glm::vec3& center = m_positions[body];
+				const CollisionTriangle& triangle = mesh.triangles()[index];
+				glm::vec3 offset = center - closestPointOnTriangle(center, triangle);
+				float_t distance2 = glm::dot(offset, offset);
+				if (distance2 >= radius * radius) {
+					continue;
+				}
+				if (distance2 > 0) {
+					float_t distance = std::sqrt(distance2);
+					resolveStaticContact(body, offset / distance, radius - distance);
+				}
+				else {
+					// The center is on the triangle: push out of the side it came from.
+					glm::vec3 normal = glm::normalize(glm::cross(triangle.b - triangle.a, triangle.c - triangle.a));
+					if (glm::dot(normal, m_velocities[body]) > 0) {
+						normal = -normal;
+					}
+					resolveStaticContact(body, normal, radius);
+				}
+			}
+		}
+	}
+}
+
+void PhysicsWorld::collideBodies() {
+	// Insertion sort by low X: nearly linear, since the order barely changes between steps.
+	for (size_t i = 1; i < m_sweepOrder.size(); i++) {
+		BodyId body = m_sweepOrder[i];
+		float_t low = m_positions[body].x - m_radii[body];
+		size_t j = i;
+		while (j > 0 && m_positions[m_sweepOrder[j - 1]].x - m_radii[m_sweepOrder[j - 1]] > low) {
+			m_sweepOrder[j] = m_sweepOrder[j - 1];
+			j--;
+		}
+		m_sweepOrder[j] = body;
+	}
+
+	for (size_t i = 0; i < m_sweepOrder.size(); i++) {
+		BodyId a = m_sweepOrder[i];
+		float_t high = m_positions[a].x + m_radii[a];
+		for (size_t j = i + 1; j < m_sweepOrder.size(); j++) {
+			BodyId b = m_sweepOrder[j];
+			if (m_positions[b].x - m_radii[b] > high) {
+				// Every later body starts further right still.
+				break;
+			}
+			float_t weight = m_inverseMasses[a] + m_inverseMasses[b];
+			if (weight == 0) {
+				continue;
+			}
+			glm::vec3 offset = m_positions[b] - m_positions[a];
+			float_t reach = m_radii[a] + m_radii[b];
+			float_t distance2 = glm::dot(offset, offset);
+			if (distance2 >= reach * reach) {
+				continue;
+			}
+			float_t distance = std::sqrt(distance2);
+			glm::vec3 normal = distance > 0 ? offset / distance : glm::vec3(0, 1, 0);
+
+			// Separate in proportion to inverse mass, so a lighter body gives way more.
+			float_t depth = reach - distance;
+			m_positions[a] -= normal * (depth * m_inverseMasses[a] / weight);
+			m_positions[b] += normal * (depth * m_inverseMasses[b] / weight);
+
+			float_t approach = glm::dot(m_velocities[b] - m_velocities[a], normal);
+			if (approach >= 0) {
+				continue;
+			}
+			float_t restitution = -approach > RESTING_SPEED ? std::min(m_restitutions[a], m_restitutions[b]) : 0;
+			float_t impulse = -(1 + restitution) * approach / weight;
+			m_velocities[a] -= normal * (impulse * m_inverseMasses[a]);
+			m_velocities[b] += normal * (impulse * m_inverseMasses[b]);
+		}
+	}
+}
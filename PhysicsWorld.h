@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Collision.h"
+#include "TriangleBVH.h"
+
+/**
+ * @brief Simulates spherical rigid bodies bouncing off static level geometry (boxes and
+ * triangle meshes) and off each other.
+ *
+ * Body state is stored as parallel arrays, one entry per body, so each stage of a step streams
+ * through only the fields it needs. A step integrates every body with semi-implicit Euler
+ * (velocity first, then position from the new velocity). Bodies are swept along their motion
+ * against static geometry, so a fast body stops at the first surface in its path instead of
+ * passing through thin walls between steps. Then contacts are resolved:
+ * - against static boxes, found through a uniform grid over the XZ plane, so a body only
+ *   tests the boxes in the cells it overlaps;
+ * - against static meshes, found through each mesh's TriangleBVH;
+ * - against other bodies, found by sweep and prune: bodies are kept sorted by the low X of
+ *   their bounds, and only bodies whose X intervals overlap are tested. Bodies move little
+ *   between steps, so re-sorting the nearly sorted list is close to linear.
+ */
+class PhysicsWorld {
+public:
+	using BodyId = uint32_t;
+
+private:
+	// Body state, indexed by BodyId.
+	std::vector<glm::vec3> m_positions;
+	std::vector<glm::vec3> m_velocities;
+	std::vector<glm::vec3> m_forces;
+	std::vector<float_t> m_inverseMasses;
+	std::vector<float_t> m_radii;
+	// The fraction of the approach speed a body keeps after a collision.
+	std::vector<float_t> m_restitutions;
+	// The fraction of sliding speed a body loses at each contact.
+	std::vector<float_t> m_frictions;
+
+	glm::vec3 m_gravity;
+
+	// Static geometry. Grid cells list box indices.
+	std::vector<BoundingBox> m_staticBoxes;
+	float_t m_cellSize;
+	std::unordered_map<uint64_t, std::vector<uint32_t>> m_cells;
+	// The query that last visited each box, so a box spanning several cells is tested once.
+	std::vector<uint32_t> m_boxVisits;
+	uint32_t m_query;
+	std::vector<TriangleBVH> m_staticMeshes;
+
+	// Body ids sorted by the low X of their bounds, for sweep and prune.
+	std::vector<BodyId> m_sweepOrder;
+	// Scratch space for static box and triangle queries.
+	std::vector<uint32_t> m_candidates;
+	std::vector<uint32_t> m_triangles;
+
+	static const uint32_t MAX_SWEEPS = 4;
+
+	uint64_t cellKey(int32_t x, int32_t z) const;
+	
+	/**
+	 * @brief Collects the static boxes in the grid cells the box overlaps into m_candidates,
+	 * each once.
+	 */
+	void gatherStaticBoxes(const glm::vec3& min, const glm::vec3& max);
+
+	void integrate(float_t dt);
+	/**
+	 * @brief Moves a body by its velocity for dt seconds. At each static surface in its path the
+	 * body bounces, and continues with the time left, up to MAX_SWEEPS surfaces per step.
+	 */
+	void sweep(BodyId body, float_t dt);
+	void collideStatic();
+	void collideBodies();
+
+	/**
+	 * @brief Separates a body from static geometry along the contact normal, and bounces it.
+	 */
+	void resolveStaticContact(BodyId body, const glm::vec3& normal, float_t depth);
+
+public:
+	/**
+	 * @brief Constructs an empty world. Static geometry is binned into square columns of the
+	 * given width.
+	 */
+	PhysicsWorld(const glm::vec3& gravity = glm::vec3(0, -9.8f, 0), float_t cellSize = 8);
+
+	/**
+	 * @brief Adds a sphere. A mass of 0 makes the body immovable.
+	 */
+	BodyId addSphere(const glm::vec3& position, float_t radius, float_t mass, float_t restitution = 0.5f,
+		float_t friction = 0.3f);
+
+	/**
+	 * @brief Adds an immovable box.
+	 */
+	void addStaticBox(const BoundingBox& box);
+
+	/**
+	 * @brief Adds an immovable triangle mesh.
+	 */
+	void addStaticMesh(TriangleBVH&& mesh);
+
+	/**
+	 * @brief Adds immovable triangles, three indices per triangle, as one mesh.
+	 */
+	void addStaticTriangles(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+	size_t bodyCount() const;
+	const glm::vec3& position(BodyId body) const;
+	const glm::vec3& velocity(BodyId body) const;
+	void setPosition(BodyId body, const glm::vec3& position);
+	void setVelocity(BodyId body, const glm::vec3& velocity);
+
+	/**
+	 * @brief Applies a force to the body for the next step only.
+	 */
+	void addForce(BodyId body, const glm::vec3& force);
+
+	/**
+	 * @brief Advances every body by dt seconds.
+	 */
+	void step(float_t dt);
+
+	/**
+	 * @brief Appends the static boxes and triangles that may overlap the region, for callers
+	 * that run their own narrow phase against static geometry.
+	 */
+	void queryStatic(const BoundingBox& region, std::vector<BoundingBox>& boxes,
+		std::vector<CollisionTriangle>& triangles);
+
+	/**
+	 * @brief Finds the nearest static mesh triangle hit by a ray within maxDistance. The
+	 * direction must be unit length.
+	 */
+	bool raycastStatic(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+		CastHit& hit) const;
+};
@@ -0,0 +1,303 @@
+#include "PortalCells.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+	// Chains of portals longer than this are not followed.
+	const uint32_t MAX_PORTAL_DEPTH = 16;
+	// A viewer this close to a portal's plane is standing in the doorway: the portal's edges
+	// give no useful planes, so the cell beyond is seen through the whole current volume.
+	const float_t DOORWAY_DISTANCE = 0.5f;
+
+	bool outsidePlanes(const BoundingBox& box, const glm::vec4* planes, uint32_t count) {
+		for (uint32_t i = 0; i < count; i++) {
+			glm::vec3 normal(planes[i]);
+			glm::vec3 farthest(normal.x >= 0 ? box.max.x : box.min.x, normal.y >= 0 ? box.max.y : box.min.y,
+				normal.z >= 0 ? box.max.z : box.min.z);
+			if (glm::dot(normal, farthest) + planes[i].w < 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Clips the convex polygon to the inside of the plane (Sutherland and Hodgman).
+	 */
+	void clipPolygon(std::vector<glm::vec3>& polygon, const glm::vec4& plane, std::vector<glm::vec3>& scratch) {
+		scratch.clear();
+		glm::vec3 normal(plane);
+		for (size_t i = 0; i < polygon.size(); i++) {
+			const glm::vec3& a = polygon[i];
+			const glm::vec3& b = polygon[(i + 1) % polygon.size()];
+			float_t da = glm::dot(normal, a) + plane.w;
+			float_t db = glm::dot(normal, b) + plane.w;
+			if (da >= 0) {
+				scratch.push_back(a);
+			}
+			if ((da >= 0) != (db >= 0)) {
+				scratch.push_back(a + (b - a) * (da / (da - db)));
+			}
+		}
+		polygon.swap(scratch);
+	}
+
+	/**
+	 * @brief The plane through the three points, facing inside toward the given point.
+	 */
+	bool planeFacing(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& inside,
+		glm::vec4& plane) {
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float_t length = glm::length(normal);
+		if (length < 1e-6f) {
+			return false;
+		}
+		normal = normal / length;
+		if (glm::dot(normal, inside - a) < 0) {
+			normal = -normal;
+		}
+		plane = glm::vec4(normal, -glm::dot(normal, a));
+		return true;
+	}
+}
+
+void VisibleCells::clear() {
+	m_graph = nullptr;
+	m_entries.clear();
+	m_planes.clear();
+}
+
+bool VisibleCells::active() const {
+	return m_graph != nullptr;
+}
+
+bool VisibleCells::isVisible(uint32_t cell) const {
+	for (auto& entry : m_entries) {
+		if (entry.cell == cell) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool VisibleCells::test(const BoundingBox& box) const {
+	if (m_graph == nullptr || !m_graph->overlapsAnyCell(box)) {
+		return true;
+	}
+	for (auto& entry : m_entries) {
+		if (m_graph->overlapsCell(entry.cell, box)
+			&& !outsidePlanes(box, &m_planes[entry.firstPlane], entry.planeCount)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+PortalCells PortalCells::load(const std::string& path) {
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("Could not open portal cells " + path);
+	}
+
+	PortalCells cells;
+	std::string line;
+	size_t lineNumber = 0;
+	auto malformed = [&path, &lineNumber](const std::string& what) {
+		return std::runtime_error(what + " on line " + std::to_string(lineNumber) + " of " + path);
+	};
+	while (std::getline(file, line)) {
+		lineNumber++;
+		std::istringstream fields(line);
+		std::string keyword;
+		if (!(fields >> keyword) || keyword[0] == '#') {
+			continue;
+		}
+		if (keyword == "cell") {
+			Cell cell;
+			if (!(fields >> cell.name)) {
+				throw malformed("Unnamed cell");
+			}
+			if (cells.findCell(cell.name) >= 0) {
+				throw malformed("Duplicate cell " + cell.name);
+			}
+			cells.m_cells.push_back(std::move(cell));
+		}
+		else if (keyword == "box") {
+			BoundingBox box;
+			if (cells.m_cells.empty()) {
+				throw malformed("Box outside a cell");
+			}
+			if (!(fields >> box.min.x >> box.min.y >> box.min.z >> box.max.x >> box.max.y >> box.max.z)
+				|| box.isEmpty()) {
+				throw malformed("Malformed box");
+			}
+			cells.m_cells.back().boxes.push_back(box);
+		}
+		else if (keyword == "portal") {
+			std::string names[2];
+			Portal portal;
+			if (!(fields >> names[0] >> names[1])) {
+				throw malformed("Malformed portal");
+			}
+			for (size_t i = 0; i < 2; i++) {
+				int32_t cell = cells.findCell(names[i]);
+				if (cell < 0) {
+					throw malformed("Unknown cell " + names[i]);
+				}
+				portal.cells[i] = static_cast<uint32_t>(cell);
+			}
+			std::vector<float_t> coordinates;
+			float_t coordinate;
+			while (fields >> coordinate) {
+				coordinates.push_back(coordinate);
+			}
+			if (!fields.eof() || coordinates.size() % 3 != 0 || coordinates.size() < 9) {
+				throw malformed("Malformed portal polygon");
+			}
+			for (size_t i = 0; i < coordinates.size(); i += 3) {
+				portal.points.emplace_back(coordinates[i], coordinates[i + 1], coordinates[i + 2]);
+			}
+			uint32_t index = static_cast<uint32_t>(cells.m_portals.size());
+			cells.m_cells[portal.cells[0]].portals.push_back(index);
+			cells.m_cells[portal.cells[1]].portals.push_back(index);
+			cells.m_portals.push_back(std::move(portal));
+		}
+		else {
+			throw malformed("Unknown statement " + keyword);
+		}
+	}
+	for (auto& cell : cells.m_cells) {
+		if (cell.boxes.empty()) {
+			throw std::runtime_error("Cell " + cell.name + " has no boxes in " + path);
+		}
+	}
+	return cells;
+}
+
+int32_t PortalCells::findCell(const std::string& name) const {
+	for (size_t i = 0; i < m_cells.size(); i++) {
+		if (m_cells[i].name == name) {
+			return static_cast<int32_t>(i);
+		}
+	}
+	return -1;
+}
+
+int32_t PortalCells::findCell(const glm::vec3& point) const {
+	for (size_t i = 0; i < m_cells.size(); i++) {
+		for (auto& box : m_cells[i].boxes) {
+			if (box.contains(point)) {
+				return static_cast<int32_t>(i);
+			}
+		}
+	}
+	return -1;
+}
+
+size_t PortalCells::cellCount() const {
+	return m_cells.size();
+}
+
+const std::string& PortalCells::cellName(uint32_t cell) const {
+	return m_cells[cell].name;
+}
+
+bool PortalCells::overlapsCell(uint32_t cell, const BoundingBox& box) const {
+	for (auto& cellBox : m_cells[cell].boxes) {
+		if (cellBox.overlaps(box)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PortalCells::overlapsAnyCell(const BoundingBox& box) const {
+	for (uint32_t i = 0; i < m_cells.size(); i++) {
+		if (overlapsCell(i, box)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void PortalCells::findVisible(const glm::vec3& viewPos, const Frustum& frustum, VisibleCells& visible) const {
+	visible.clear();
+	int32_t start = findCell(viewPos);
+	if (start < 0) {
+		return;
+	}
+	visible.m_graph = this;
+	visible.m_planes.assign(frustum.planes, frustum.planes + 6);
+	visible.m_entries.push_back(VisibleCells::Entry{ static_cast<uint32_t>(start), 0, 6 });
+	std::vector<uint32_t> path{ static_cast<uint32_t>(start) };
+	// Fifth and sixth are the near and far planes; the far plane bounds every cell's volume.
+	visit(static_cast<uint32_t>(start), viewPos, frustum.planes[5], 0, path, visible);
+}
+
+void PortalCells::visit(uint32_t cell, const glm::vec3& viewPos, const glm::vec4& farPlane, uint32_t depth,
+	std::vector<uint32_t>& path, VisibleCells& visible) const {
+	if (depth >= MAX_PORTAL_DEPTH) {
+		return;
+	}
+	// The volume this cell is seen through; copied, since visiting neighbours appends planes.
+	const auto& entry = visible.m_entries.back();
+	std::vector<glm::vec4> volume(visible.m_planes.begin() + entry.firstPlane,
+		visible.m_planes.begin() + entry.firstPlane + entry.planeCount);
+
+	std::vector<glm::vec3> polygon;
+	std::vector<glm::vec3> scratch;
+	for (uint32_t index : m_cells[cell].portals) {
+		const Portal& portal = m_portals[index];
+		uint32_t next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+		if (std::find(path.begin(), path.end(), next) != path.end()) {
+			continue;
+		}
+
+		glm::vec4 portalPlane;
+		if (!planeFacing(portal.points[0], portal.points[1], portal.points[2], viewPos, portalPlane)) {
+			continue;
+		}
+		bool doorway = std::abs(glm::dot(glm::vec3(portalPlane), viewPos) + portalPlane.w) < DOORWAY_DISTANCE;
+
+		uint32_t firstPlane = static_cast<uint32_t>(visible.m_planes.size());
+		if (doorway) {
+			visible.m_planes.insert(visible.m_planes.end(), volume.begin(), volume.end());
+		}
+		else {
+			// Only the part of the portal inside the current volume can be seen through.
+			polygon = portal.points;
+			for (auto& plane : volume) {
+				clipPolygon(polygon, plane, scratch);
+				if (polygon.size() < 3) {
+					break;
+				}
+			}
+			if (polygon.size() < 3) {
+				continue;
+			}
+			// The new volume: a plane through the viewer and each edge of what is left of the
+			// portal, the portal itself (so the viewer's side is excluded), and the far plane.
+			glm::vec3 inside(0);
+			for (auto& point : polygon) {
+				inside = inside + point;
+			}
+			inside = inside * (1.0f / polygon.size());
+			for (size_t i = 0; i < polygon.size(); i++) {
+				glm::vec4 plane;
+				if (planeFacing(viewPos, polygon[i], polygon[(i + 1) % polygon.size()], inside, plane)) {
+					visible.m_planes.push_back(plane);
+				}
+			}
+			visible.m_planes.push_back(-portalPlane);
+			visible.m_planes.push_back(farPlane);
+		}
+		visible.m_entries.push_back(VisibleCells::Entry{ next, firstPlane,
+			static_cast<uint32_t>(visible.m_planes.size()) - firstPlane });
+		path.push_back(next);
+		visit(next, viewPos, farPlane, depth + 1, path, visible);
+		path.pop_back();
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Frustum.h"
+
+class PortalCells;
+
+/**
+ * @brief The cells of a PortalCells graph a viewer can see this frame, each with the volume it
+ * is seen through: the view frustum, narrowed by every portal on the way to the cell.
+ */
+class VisibleCells {
+private:
+	friend class PortalCells;
+
+	struct Entry {
+		uint32_t cell;
+		uint32_t firstPlane;
+		uint32_t planeCount;
+	};
+
+	// The graph the viewer is in, or null when the viewer is in none of its cells.
+	const PortalCells* m_graph = nullptr;
+	std::vector<Entry> m_entries;
+	std::vector<glm::vec4> m_planes;
+
+public:
+	/**
+	 * @brief Forgets the visible cells; everything passes until the next PortalCells::findVisible.
+	 */
+	void clear();
+
+	/**
+	 * @brief Whether the viewer was in a cell, so that test() can reject anything.
+	 */
+	bool active() const;
+
+	/**
+	 * @brief Whether the cell was reached.
+	 */
+	bool isVisible(uint32_t cell) const;
+
+	/**
+	 * @brief Whether the box may be visible: it is in a reached cell and inside the volume that
+	 * cell is seen through. Bounds outside every cell cannot be judged by the graph, so they
+	 * pass, as does everything when the viewer is outside the cells.
+	 */
+	bool test(const BoundingBox& box) const;
+};
+
+/**
+ * @brief Portal visibility for indoor levels. The level is divided into cells (rooms and
+ * corridors, each a union of boxes) joined by portals (convex polygons covering the doorways).
+ * Starting from the viewer's cell, each portal in view narrows the frustum to the volume seen
+ * through it, and the cell beyond is visited with that volume; a cell is potentially visible
+ * only if some chain of portals from the viewer reaches it. Walls between cells need not be
+ * tested at all, so this costs a handful of polygon clips per frame.
+ */
+class PortalCells {
+private:
+	struct Cell {
+		std::string name;
+		std::vector<BoundingBox> boxes;
+		std::vector<uint32_t> portals;
+	};
+
+	struct Portal {
+		uint32_t cells[2];
+		std::vector<glm::vec3> points;
+	};
+
+	std::vector<Cell> m_cells;
+	std::vector<Portal> m_portals;
+
+	int32_t findCell(const std::string& name) const;
+	void visit(uint32_t cell, const glm::vec3& viewPos, const glm::vec4& farPlane, uint32_t depth,
+		std::vector<uint32_t>& path, VisibleCells& visible) const;
+
+public:
+	PortalCells() = default;
+
+	/**
+	 * @brief Loads cells and portals from a text file with one statement per line. Blank lines
+	 * and lines starting with # are ignored.
+	 *   cell name                             starts a cell
+	 *   box minX minY minZ maxX maxY maxZ     adds a box to the last cell
+	 *   portal cellA cellB x y z x y z ...    joins two cells through a convex polygon of 3 or
+	 *                                         more points, in order around its edge
+	 */
+	static PortalCells load(const std::string& path);
+
+	/**
+	 * @brief The cell containing the point, or -1 if it is in none.
+	 */
+	int32_t findCell(const glm::vec3& point) const;
+	size_t cellCount() const;
+	const std::string& cellName(uint32_t cell) const;
+
+	bool overlapsCell(uint32_t cell, const BoundingBox& box) const;
+	bool overlapsAnyCell(const BoundingBox& box) const;
+
+	/**
+	 * @brief Finds the cells visible from viewPos within the frustum (from Frustum::fromMatrix).
+	 * If viewPos is in no cell, visible is left inactive and culls nothing.
+	 */
+	void findVisible(const glm::vec3& viewPos, const Frustum& frustum, VisibleCells& visible) const;
+};
@@ -0,0 +1,30 @@
+#include "RenderSnapshot.h"
+#include <algorithm>
+
+void RenderSnapshot::clear() {
+	lighting = nullptr;
+	draws.clear();
+	lights.clear();
+	spotLights.clear();
+	retired.clear();
+}
+
+void RenderSnapshot::addObjects(const std::vector<const Object3D*>& objects, JobSystem& jobs,
+	const VisibleCells* cells) {
+	if (objectDraws.size() < objects.size()) {
+		objectDraws.resize(objects.size());
+	}
+	DrawView view{ viewPos, Frustum::fromMatrix(projection * this->view), projection[1][1], cells };
+	jobs.parallelFor(objects.size(), 16, [&](size_t i) {
+		objectDraws[i].clear();
+		objects[i]->addDrawItems(objectDraws[i], glm::mat4(1), view);
+	});
+	for (size_t i = 0; i < objects.size(); i++) {
+		draws.insert(draws.end(), objectDraws[i].begin(), objectDraws[i].end());
+	}
+}
+
+void RenderSnapshot::sortFrontToBack() {
+	std::stable_sort(draws.begin(), draws.end(),
+		[](const DrawItem& a, const DrawItem& b) { return a.depthKey < b.depthKey; });
+}
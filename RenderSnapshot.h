@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "Mesh3D.h"
+#include "Object3D.h"
+#include "ShaderProgram.h"
+#include "ClusteredLights.h"
+#include "JobSystem.h"
+#include "PortalCells.h"
+
+/**
+ * @brief One mesh to draw, with the matrices to draw it with.
+ */
+struct DrawItem {
+	const Mesh3D* mesh;
+	glm::mat4 model;
+	glm::mat3 normalMatrix;
+	// The squared distance from the viewer to the mesh's world-space bounds.
+	float_t depthKey;
+	// The mesh's level of detail to draw.
+	uint32_t lod;
+};
+
+/**
+ * @brief What building the draw list needs to know about the viewer.
+ */
+struct DrawView {
+	glm::vec3 viewPos;
+	Frustum frustum;
+	// The projection's [1][1], cot(fov / 2), which turns a bounding radius over a distance into
+	// a size on screen.
+	float_t projectionScale;
+	// If set, meshes the viewer cannot see through the level's portals are left out.
+	const VisibleCells* cells;
+};
+
+/**
+ * @brief Everything the render thread needs to draw one frame, built by the simulation thread:
+ * the draw list with its matrices, the view, and the frame's lights. A published snapshot is
+ * never modified while the render thread reads it, so neither thread waits on the other.
+ *
+ * Meshes are referenced rather than copied; their GPU data does not change after loading.
+ */
+struct RenderSnapshot {
+	// The lighting program variant of the scene being shown.
+	ShaderProgram* lighting = nullptr;
+	glm::mat4 view = glm::mat4(1);
+	glm::mat4 projection = glm::mat4(1);
+	glm::vec3 viewPos = glm::vec3(0);
+	glm::vec3 viewFront = glm::vec3(0, 0, -1);
+	// The meshes to draw, front to back.
+	std::vector<DrawItem> draws;
+	std::vector<PointLightData> lights;
+	std::vector<SpotLightData> spotLights;
+	// Objects removed from their scene while building this snapshot. Older snapshots may still
+	// draw their meshes, so they are destroyed only once this snapshot is recycled.
+	std::vector<Object3D> retired;
+	// Scratch space: each root object's draws, gathered in parallel before they are joined.
+	std::vector<std::vector<DrawItem>> objectDraws;
+
+	/**
+	 * @brief Empties the snapshot for reuse, keeping its allocations.
+	 */
+	void clear();
+
+	/**
+	 * @brief Adds the meshes of the objects and their children in view to the draw list. Set
+	 * view, viewPos and projection first: each mesh is culled against the frustum and, if given,
+	 * the visible cells, keyed by its distance from the viewer, and drawn at a level of detail
+	 * chosen by its size on screen. Each root object's hierarchy is walked as its own job.
+	 */
+	void addObjects(const std::vector<const Object3D*>& objects, JobSystem& jobs,
+		const VisibleCells* cells = nullptr);
+
+	/**
+	 * @brief Orders the draw list by increasing distance from the viewer, so early depth testing
+	 * rejects as many hidden fragments as it can.
+	 */
+	void sortFrontToBack();
+};
@@ -0,0 +1,330 @@
+#include "Renderer.h"
+#include <glad/glad.h>
+#include <stdexcept>
+
+// Items whose bounds come this close to the viewer are always treated as seen.
+const float_t OCCLUSION_NEAR_MARGIN = 1.0f;
+
+Renderer::Renderer(Mode mode)
+	: m_mode(mode), m_gBuffer(0), m_albedoTexture(0), m_normalTexture(0), m_depthTexture(0),
+	m_width(0), m_height(0), m_fullscreenVao(0), m_depthPrepass(false), m_occlusionCulling(false), m_frame(0),
+	m_occlusionBox(Mesh3D::cube({})) {
+	m_depthShader = ShaderProgram::variant("shaders/depth_only.vert", "shaders/depth_only.frag", ShaderDefines());
+	if (m_mode == Mode::Deferred) {
+		m_geometryShader = ShaderProgram::variant("shaders/light_perspective.vert", "shaders/gbuffer.frag",
+			ShaderDefines());
+		glGenVertexArrays(1, &m_fullscreenVao);
+	}
+}
+
+Renderer::~Renderer() {
+	releaseGBuffer();
+	if (m_fullscreenVao != 0) {
+		glDeleteVertexArrays(1, &m_fullscreenVao);
+	}
+	for (auto& entry : m_occlusion) {
+		m_freeQueries.push_back(entry.second.query);
+	}
+	if (!m_freeQueries.empty()) {
+		glDeleteQueries(static_cast<GLsizei>(m_freeQueries.size()), m_freeQueries.data());
+	}
+}
+
+Renderer::Mode Renderer::mode() const {
+	return m_mode;
+}
+
+void Renderer::setDepthPrepass(bool enabled) {
+	m_depthPrepass = enabled;
+}
+
+bool Renderer::depthPrepass() const {
+	return m_depthPrepass;
+}
+
+void Renderer::setOcclusionCulling(bool enabled) {
+	m_occlusionCulling = enabled;
+}
+
+bool Renderer::occlusionCulling() const {
+	return m_occlusionCulling;
+}
+
+void Renderer::beginOcclusionFrame(const RenderSnapshot& snapshot) {
+	m_frame++;
+	for (auto& entry : m_occlusion) {
+		OcclusionState& state = entry.second;
+		if (state.pending) {
+			// An answer that is somehow still not in counts as seen, rather than waiting for it.
+			GLuint available = 0;
+			glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+			GLuint passed = 1;
+			if (available) {
+				glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &passed);
+			}
+			state.visible = passed != 0;
+			state.pending = false;
+		}
+	}
+
+	const auto& draws = snapshot.draws;
+	m_itemQueries.resize(draws.size());
+	m_itemHidden.assign(draws.size(), false);
+	float_t margin = OCCLUSION_NEAR_MARGIN;
+	for (size_t i = 0; i < draws.size(); i++) {
+		auto& draw = draws[i];
+		auto found = m_occlusion.find(draw.mesh);
+		if (found == m_occlusion.end()) {
+			uint32_t query;
+			if (!m_freeQueries.empty()) {
+				query = m_freeQueries.back();
+				m_freeQueries.pop_back();
+			}
+			else {
+				glGenQueries(1, &query);
+			}
+			found = m_occlusion.emplace(draw.mesh, OcclusionState{ query, true, false, 0 }).first;
+		}
+		found->second.frame = m_frame;
+		m_itemQueries[i] = found->second.query;
+		m_itemHidden[i] = !found->second.visible
+			&& draw.mesh->getBounds().transformed(draw.model).distanceSquared(snapshot.viewPos) > margin * margin;
+	}
+
+	for (auto entry = m_occlusion.begin(); entry != m_occlusion.end();) {
+		if (entry->second.frame != m_frame) {
+			m_freeQueries.push_back(entry->second.query);
+			entry = m_occlusion.erase(entry);
+		}
+		else {
+			++entry;
+		}
+	}
+}
+
+void Renderer::drawItems(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& program,
+	OcclusionPass occlusion, bool colourWrites) {
+	const auto& draws = snapshot.draws;
+	if (occlusion == OcclusionPass::None) {
+		for (auto& draw : draws) {
+			drawItem(window, draw, program);
+		}
+		return;
+	}
+
+	// The items seen last frame, front to back, so they fill the depth buffer the rest are tested
+	// against. Each is drawn inside its query, so its own samples say whether it is still seen.
+	for (size_t i = 0; i < draws.size(); i++) {
+		if (m_itemHidden[i]) {
+			continue;
+		}
+		if (occlusion == OcclusionPass::Test) {
+			glBeginQuery(GL_ANY_SAMPLES_PASSED, m_itemQueries[i]);
+			drawItem(window, draws[i], program);
+			glEndQuery(GL_ANY_SAMPLES_PASSED);
+			m_occlusion[draws[i].mesh].pending = true;
+		}
+		else {
+			drawItem(window, draws[i], program);
+		}
+	}
+
+	if (occlusion == OcclusionPass::Test) {
+		queryHiddenBounds(window, snapshot);
+		glColorMask(colourWrites, colourWrites, colourWrites, colourWrites);
+		program.activate();
+	}
+
+	// The items hidden last frame, each only if its box passed. The answers are rarely in this
+	// soon, but the GPU does not wait for them: it draws the item if its answer is not.
+	for (size_t i = 0; i < draws.size(); i++) {
+		if (!m_itemHidden[i]) {
+			continue;
+		}
+		glBeginConditionalRender(m_itemQueries[i], GL_QUERY_BY_REGION_NO_WAIT);
+		drawItem(window, draws[i], program);
+		glEndConditionalRender();
+	}
+}
+
+void Renderer::drawItem(sf::RenderWindow& window, const DrawItem& draw, ShaderProgram& program) {
+	program.setUniform("model", draw.model);
+	program.setUniform("normalMatrix", draw.normalMatrix);
+	draw.mesh->render(window, program, draw.lod);
+}
+
+void Renderer::queryHiddenBounds(sf::RenderWindow& window, const RenderSnapshot& snapshot) {
+	const auto& draws = snapshot.draws;
+	bool started = false;
+	for (size_t i = 0; i < draws.size(); i++) {
+		if (!m_itemHidden[i]) {
+			continue;
+		}
+		if (!started) {
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			glDepthMask(GL_FALSE);
+			m_depthShader.activate();
+			started = true;
+		}
+		// The unit cube, stretched and moved onto the item's world-space bounds.
+		BoundingBox bounds = draws[i].mesh->getBounds().transformed(draws[i].model);
+		glm::vec3 size = bounds.max - bounds.min;
+		glm::mat4 model(1);
+		model[0][0] = size.x;
+		model[1][1] = size.y;
+		model[2][2] = size.z;
+		model[3] = glm::vec4(bounds.center(), 1);
+		m_depthShader.setUniform("model", model);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, m_itemQueries[i]);
+		m_occlusionBox.render(window, m_depthShader);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		m_occlusion[draws[i].mesh].pending = true;
+	}
+	if (started) {
+		glDepthMask(GL_TRUE);
+	}
+}
+
+void Renderer::allocateGBuffer(uint32_t width, uint32_t height) {
+	releaseGBuffer();
+	m_width = width;
+	m_height = height;
+
+	glGenFramebuffers(1, &m_gBuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_gBuffer);
+
+	// Attachment 0: base colour. Attachment 1: world-space normal, signed so half floats.
+	// The depth attachment is a texture so the lighting pass can rebuild positions from it.
+	auto attach = [width, height](uint32_t& texture, GLint internalFormat, GLenum format, GLenum type,
+		GLenum attachment) {
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D, texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+	};
+	attach(m_albedoTexture, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, GL_COLOR_ATTACHMENT0);
+	attach(m_normalTexture, GL_RGB16F, GL_RGB, GL_FLOAT, GL_COLOR_ATTACHMENT1);
+	attach(m_depthTexture, GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_FLOAT, GL_DEPTH_ATTACHMENT);
+
+	GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(2, drawBuffers);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		throw std::runtime_error("G-buffer framebuffer is incomplete");
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Renderer::releaseGBuffer() {
+	if (m_gBuffer == 0) {
+		return;
+	}
+	uint32_t textures[] = { m_albedoTexture, m_normalTexture, m_depthTexture };
+	glDeleteTextures(3, textures);
+	glDeleteFramebuffers(1, &m_gBuffer);
+	m_gBuffer = 0;
+}
+
+void Renderer::render(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& lighting,
+	const glm::mat4& projection) {
+	if (m_occlusionCulling) {
+		beginOcclusionFrame(snapshot);
+	}
+	if (m_mode == Mode::Deferred) {
+		renderDeferred(window, snapshot, lighting, projection);
+	}
+	else {
+		renderForward(window, snapshot, lighting, projection);
+	}
+}
+
+void Renderer::renderForward(sf::RenderWindow& window, const RenderSnapshot& snapshot,
+	ShaderProgram& lighting, const glm::mat4& projection) {
+	const glm::mat4& view = snapshot.view;
+	// The depth shader also draws the occlusion queries' boxes.
+	m_depthShader.activate();
+	m_depthShader.setUniform("view", view);
+	m_depthShader.setUniform("projection", projection);
+	// The first pass tests each item against what is drawn before it; a second pass reuses its answers.
+	OcclusionPass occlusion = m_occlusionCulling ? OcclusionPass::Test : OcclusionPass::None;
+	if (m_depthPrepass) {
+		// Depth only: no colour writes, nothing but the vertex transform.
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		drawItems(window, snapshot, m_depthShader, occlusion, false);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		if (m_occlusionCulling) {
+			occlusion = OcclusionPass::Reuse;
+		}
+
+		// Only the fragment that won the pre-pass passes GL_EQUAL, so each pixel is lit once.
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	lighting.activate();
+	lighting.setUniform("viewPos", snapshot.viewPos);
+	lighting.setUniform("view", view);
+	lighting.setUniform("projection", projection);
+	drawItems(window, snapshot, lighting, occlusion);
+
+	if (m_depthPrepass) {
+		glDepthMask(GL_TRUE);
+		glDepthFunc(GL_LESS);
+	}
+}
+
+void Renderer::renderDeferred(sf::RenderWindow& window, const RenderSnapshot& snapshot,
+	ShaderProgram& lighting, const glm::mat4& projection) {
+	const glm::mat4& view = snapshot.view;
+	auto size = window.getSize();
+	if (m_gBuffer == 0 || size.x != m_width || size.y != m_height) {
+		allocateGBuffer(size.x, size.y);
+	}
+
+	// Geometry pass: fill the G-buffer. Hidden surfaces cost only a texture fetch here.
+	glBindFramebuffer(GL_FRAMEBUFFER, m_gBuffer);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	if (m_occlusionCulling) {
+		m_depthShader.activate();
+		m_depthShader.setUniform("view", view);
+		m_depthShader.setUniform("projection", projection);
+	}
+	m_geometryShader.activate();
+	m_geometryShader.setUniform("view", view);
+	m_geometryShader.setUniform("projection", projection);
+	drawItems(window, snapshot, m_geometryShader,
+		m_occlusionCulling ? OcclusionPass::Test : OcclusionPass::None);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// Lighting pass: one fullscreen triangle, lighting each pixel's front-most surface.
+	lighting.activate();
+	lighting.setUniform("viewPos", snapshot.viewPos);
+	lighting.setUniform("view", view);
+	lighting.setUniform("inverseViewProjection", glm::inverse(projection * view));
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, m_albedoTexture);
+	lighting.setUniform("gAlbedo", 0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, m_normalTexture);
+	lighting.setUniform("gNormal", 1);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+	lighting.setUniform("gDepth", 2);
+
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(m_fullscreenVao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+
+	for (int32_t unit = 2; unit >= 0; unit--) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
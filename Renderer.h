@@ -0,0 +1,147 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include <glm/glm.hpp>
+#include "RenderSnapshot.h"
+#include "ShaderProgram.h"
+
+/**
+ * @brief Draws a render snapshot's draw list with a lighting shader program.
+ *
+ * In Forward mode every object is drawn straight to the window with the lighting program
+ * (a multilights.frag variant), so every rasterized fragment is lit, even ones later hidden.
+ * In Deferred mode the objects are first drawn into a G-buffer (albedo, normal, depth) with a
+ * cheap shader, then the lighting program (a deferred_lighting.frag variant) lights each
+ * screen pixel exactly once.
+ *
+ * Forward mode can optionally run a depth pre-pass: all objects are first drawn with a
+ * position-only shader to fill the depth buffer, then drawn again with lighting and a GL_EQUAL
+ * depth test, so only the visible surface of each pixel is lit. Without the pre-pass, the
+ * snapshot's front-to-back order lets early depth testing reject as many hidden fragments as it can.
+ *
+ * With occlusion culling, each mesh remembers whether it was seen last frame. The meshes that
+ * were seen are drawn first, each inside its own GL_ANY_SAMPLES_PASSED query, and fill the depth
+ * buffer. The bounding boxes of the meshes that were hidden are then drawn invisibly in one batch,
+ * each inside a query, and those meshes are drawn under conditional rendering on their boxes'
+ * queries, without waiting: the GPU skips them if the answer is in, and draws them otherwise.
+ * Every query's answer is read a frame later, when it is long finished, so neither the CPU nor
+ * the GPU ever waits for one. Later passes of the same frame draw under the same queries.
+ */
+class Renderer {
+public:
+	enum class Mode {
+		Forward,
+		Deferred
+	};
+
+private:
+	Mode m_mode;
+
+	// The G-buffer and its attachments; allocated on first use and whenever the window resizes.
+	uint32_t m_gBuffer;
+	uint32_t m_albedoTexture;
+	uint32_t m_normalTexture;
+	uint32_t m_depthTexture;
+	uint32_t m_width;
+	uint32_t m_height;
+
+	// An empty vertex array for the attribute-less fullscreen triangle.
+	uint32_t m_fullscreenVao;
+	ShaderProgram m_geometryShader;
+
+	bool m_depthPrepass;
+	ShaderProgram m_depthShader;
+
+	bool m_occlusionCulling;
+	/**
+	 * @brief A drawn mesh's occlusion query, and what its last answer was.
+	 */
+	struct OcclusionState {
+		uint32_t query;
+		// Whether any of the mesh's (or its box's) samples passed when last tested. Meshes new
+		// to the renderer count as seen.
+		bool visible;
+		// Whether the query was issued and its answer not yet read.
+		bool pending;
+		// The frame the mesh was last drawn in.
+		uint64_t frame;
+	};
+	// By mesh; meshes not drawn in a frame are forgotten, and their queries reused.
+	std::unordered_map<const Mesh3D*, OcclusionState> m_occlusion;
+	std::vector<uint32_t> m_freeQueries;
+	uint64_t m_frame;
+	// Per draw item this frame: its query, and whether it was hidden last frame, so is drawn
+	// under its box's query.
+	std::vector<uint32_t> m_itemQueries;
+	std::vector<bool> m_itemHidden;
+	// A unit cube, scaled to each item's bounds for its query.
+	Mesh3D m_occlusionBox;
+
+	/**
+	 * @brief How a pass uses occlusion queries: not at all, issuing this frame's queries, or
+	 * drawing under the queries an earlier pass of the frame issued.
+	 */
+	enum class OcclusionPass {
+		None,
+		Test,
+		Reuse
+	};
+
+	/**
+	 * @brief Reads last frame's answers, and gives each of the snapshot's items its query and
+	 * whether it was hidden. Items near the viewer are never hidden: their boxes may be clipped
+	 * by the near plane, and would then fail their queries even though they are in view.
+	 */
+	void beginOcclusionFrame(const RenderSnapshot& snapshot);
+	/**
+	 * @brief Draws each item's mesh with the item's matrices. A Test pass leaves the colour mask
+	 * as colourWrites after the box queries.
+	 */
+	void drawItems(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& program,
+		OcclusionPass occlusion, bool colourWrites = true);
+	void drawItem(sf::RenderWindow& window, const DrawItem& draw, ShaderProgram& program);
+	/**
+	 * @brief Draws the bounds of the items hidden last frame, without writing colour or depth,
+	 * each inside its item's query.
+	 */
+	void queryHiddenBounds(sf::RenderWindow& window, const RenderSnapshot& snapshot);
+
+	void allocateGBuffer(uint32_t width, uint32_t height);
+	void releaseGBuffer();
+
+	void renderForward(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& lighting,
+		const glm::mat4& projection);
+	void renderDeferred(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& lighting,
+		const glm::mat4& projection);
+
+public:
+	/**
+	 * @brief Constructs a renderer in the given mode. Requires a current OpenGL context.
+	 */
+	Renderer(Mode mode = Mode::Forward);
+	Renderer(const Renderer&) = delete;
+	Renderer& operator=(const Renderer&) = delete;
+	~Renderer();
+
+	Mode mode() const;
+
+	/**
+	 * @brief Enables or disables the depth pre-pass in Forward mode.
+	 */
+	void setDepthPrepass(bool enabled);
+	bool depthPrepass() const;
+
+	/**
+	 * @brief Enables or disables skipping meshes hidden behind nearer ones.
+	 */
+	void setOcclusionCulling(bool enabled);
+	bool occlusionCulling() const;
+
+	/**
+	 * @brief Renders the snapshot's draw list to the window. The lighting program must be the
+	 * variant for this renderer's mode; the caller sets its light and material uniforms beforehand.
+	 */
+	void render(sf::RenderWindow& window, const RenderSnapshot& snapshot, ShaderProgram& lighting,
+		const glm::mat4& projection);
+};
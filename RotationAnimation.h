@@ -23,7 +23,7 @@ public:
 	 * @brief Constructs a animation of a constant rotation by the given total rotation 
 	 * angle, linearly interpolated across the given duration.
 	 */
-	RotationAnimation(Object3D& object, float_t duration, const glm::vec3& totalRotation) : 
-		Animation(object, duration), m_perSecond(totalRotation / duration) {}
+	RotationAnimation(ObjectRef object, float_t duration, const glm::vec3& totalRotation) : 
+		Animation(std::move(object), duration), m_perSecond(totalRotation / duration) {}
 };
 
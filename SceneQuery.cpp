@@ -0,0 +1,105 @@
+#include "SceneQuery.h"
+#include "Collision.h"
+
+SceneQuery::SceneQuery(float_t margin) : m_tree(margin) {
+}
+
+SceneQuery::Entry* SceneQuery::find(const ObjectHandle& object) {
+	if (object.index >= m_entries.size()) {
+		return nullptr;
+	}
+	Entry& entry = m_entries[object.index];
+	return entry.proxy != NO_PROXY && entry.object == object ? &entry : nullptr;
+}
+
+void SceneQuery::add(const ObjectStore& objects, const ObjectHandle& object, uint32_t layers) {
+	const Object3D* value = objects.get(object);
+	if (value == nullptr) {
+		return;
+	}
+	if (object.index >= m_entries.size()) {
+		m_entries.resize(object.index + 1, Entry{ ObjectHandle(), NO_PROXY, 0, BoundingBox() });
+	}
+	// The slot may still hold an earlier object from before the store reused it, whose proxy
+	// would otherwise stay in the tree for good.
+	Entry& existing = m_entries[object.index];
+	if (existing.proxy != NO_PROXY) {
+		m_tree.remove(existing.proxy);
+		existing.proxy = NO_PROXY;
+	}
+	BoundingBox bounds = value->getWorldBounds();
+	m_entries[object.index] = Entry{ object, m_tree.insert(bounds, object.index), layers, bounds };
+}
+
+void SceneQuery::remove(const ObjectHandle& object) {
+	Entry* entry = find(object);
+	if (entry != nullptr) {
+		m_tree.remove(entry->proxy);
+		entry->proxy = NO_PROXY;
+	}
+}
+
+void SceneQuery::update(const ObjectStore& objects) {
+	for (auto& entry : m_entries) {
+		if (entry.proxy == NO_PROXY) {
+			continue;
+		}
+		const Object3D* object = objects.get(entry.object);
+		if (object == nullptr) {
+			m_tree.remove(entry.proxy);
+			entry.proxy = NO_PROXY;
+			continue;
+		}
+		BoundingBox bounds = object->getWorldBounds();
+		m_tree.move(entry.proxy, bounds, bounds.center() - entry.bounds.center());
+		entry.bounds = bounds;
+	}
+}
+
+bool SceneQuery::raycast(const ObjectStore& objects, const glm::vec3& origin, const glm::vec3& direction,
+	float_t maxDistance, uint32_t layers, bool triangles, SceneHit& hit) const {
+	if (glm::dot(direction, direction) == 0) {
+		return false;
+	}
+	auto inverse = [](float_t x) { return x != 0 ? 1 / x : 1e20f; };
+	glm::vec3 inverseDirection(inverse(direction.x), inverse(direction.y), inverse(direction.z));
+	bool found = false;
+	m_tree.raycast(origin, direction, maxDistance, [&](int32_t proxy, float_t reach) {
+		const Entry& entry = m_entries[m_tree.userData(proxy)];
+		// Objects erased since the last update are skipped.
+		const Object3D* object = objects.get(entry.object);
+		float_t distance;
+		if ((entry.layers & layers) == 0 || object == nullptr
+			|| !rayBox(origin, inverseDirection, entry.bounds, reach, distance)) {
+			return reach;
+		}
+		if (triangles && object->hasTriangles() && !object->raycastTriangles(origin, direction, reach, distance)) {
+			return reach;
+		}
+		hit = SceneHit{ entry.object, distance };
+		found = true;
+		// Only nearer objects matter now.
+		return distance;
+	});
+	return found;
+}
+
+void SceneQuery::overlapSphere(const glm::vec3& center, float_t radius, uint32_t layers,
+	std::vector<ObjectHandle>& found) const {
+	BoundingBox box(center - radius, center + radius);
+	m_tree.query(box, [&](int32_t proxy) {
+		const Entry& entry = m_entries[m_tree.userData(proxy)];
+		if ((entry.layers & layers) != 0 && entry.bounds.distanceSquared(center) <= radius * radius) {
+			found.push_back(entry.object);
+		}
+	});
+}
+
+void SceneQuery::overlapFrustum(const Frustum& frustum, uint32_t layers, std::vector<ObjectHandle>& found) const {
+	m_tree.query(frustum, [&](int32_t proxy) {
+		const Entry& entry = m_entries[m_tree.userData(proxy)];
+		if ((entry.layers & layers) != 0 && frustum.test(entry.bounds) != Frustum::Test::Outside) {
+			found.push_back(entry.object);
+		}
+	});
+}
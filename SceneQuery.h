@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "DynamicAABBTree.h"
+#include "Frustum.h"
+#include "ObjectStore.h"
+
+/**
+ * @brief An object a scene query found, and how far along the ray it was hit.
+ */
+struct SceneHit {
+	ObjectHandle object;
+	float_t distance;
+};
+
+/**
+ * @brief Answers which of a scene's root objects a ray or sphere reaches, for picking and
+ * interaction. Objects are added with a set of layer bits, and each query only reports objects
+ * on the layers it asks for.
+ *
+ * The objects' world bounds are kept in a DynamicAABBTree, so a query visits only the objects
+ * near it rather than every object. update() refreshes the bounds after objects move; an object
+ * that stays within its fattened box does not touch the tree at all. The same tree serves view
+ * culling, picking and proximity tests, each on its own layers.
+ */
+class SceneQuery {
+private:
+	struct Entry {
+		ObjectHandle object;
+		int32_t proxy;
+		uint32_t layers;
+		// The object's world bounds at the last update, tighter than the tree's fat box.
+		BoundingBox bounds;
+	};
+
+	DynamicAABBTree m_tree;
+	// Indexed by the object handle's slot index.
+	std::vector<Entry> m_entries;
+
+	static const int32_t NO_PROXY = -1;
+
+	Entry* find(const ObjectHandle& object);
+
+public:
+	static const uint32_t ALL_LAYERS = ~0u;
+
+	/**
+	 * @brief Constructs an empty query structure. Bounds are fattened by the margin, in world
+	 * units, so objects moving less than that per update are cheap.
+	 */
+	explicit SceneQuery(float_t margin = 0.5f);
+
+	/**
+	 * @brief Adds a root object of the store, on the given layers.
+	 */
+	void add(const ObjectStore& objects, const ObjectHandle& object, uint32_t layers = ALL_LAYERS);
+	void remove(const ObjectHandle& object);
+
+	/**
+	 * @brief Refreshes the bounds of every added object, and forgets objects erased from the
+	 * store.
+	 */
+	void update(const ObjectStore& objects);
+
+	/**
+	 * @brief Finds the nearest object on the given layers that a ray hits within maxDistance.
+	 * Objects are hit at their bounds; with triangles, objects whose meshes kept their triangles
+	 * are hit only on those triangles.
+	 * @param direction the ray's direction, of unit length.
+	 */
+	bool raycast(const ObjectStore& objects, const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+		uint32_t layers, bool triangles, SceneHit& hit) const;
+
+	/**
+	 * @brief Appends the objects on the given layers whose bounds are within radius of center.
+	 */
+	void overlapSphere(const glm::vec3& center, float_t radius, uint32_t layers, std::vector<ObjectHandle>& found) const;
+
+	/**
+	 * @brief Appends the objects on the given layers whose bounds are at least partly inside the
+	 * frustum.
+	 */
+	void overlapFrustum(const Frustum& frustum, uint32_t layers, std::vector<ObjectHandle>& found) const;
+};
@@ -3,6 +3,8 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <filesystem>
 
 ShaderProgram::ShaderProgram()
     : m_programId(-1) {
@@ -11,7 +13,98 @@ ShaderProgram::ShaderProgram()
 
 
 
+/**
+ * @brief Inserts one #define line per entry directly after the #version directive, which
+ * must stay the first statement of a GLSL source.
+ */
+static std::string injectDefines(const std::string& source, const ShaderDefines& defines)
+{
+    if (defines.empty()) {
+        return source;
+    }
+    std::string defineBlock;
+    for (auto& define : defines) {
+        defineBlock += "#define " + define.first + " " + define.second + "\n";
+    }
+    auto versionLine = source.find("#version");
+    if (versionLine == std::string::npos) {
+        return defineBlock + source;
+    }
+    auto afterVersion = source.find('\n', versionLine);
+    if (afterVersion == std::string::npos) {
+        return source + "\n" + defineBlock;
+    }
+    return source.substr(0, afterVersion + 1) + defineBlock + source.substr(afterVersion + 1);
+}
+
+/**
+ * @brief Replaces each line of the form #include "file" with the contents of that file, resolved
+ * relative to the including shader's directory. GLSL has no includes of its own; this lets
+ * several shaders share one copy of common code such as lights.glsl.
+ */
+static std::string resolveIncludes(const std::string& source, const std::filesystem::path& directory,
+    int32_t depth = 0)
+{
+    if (depth > 8) {
+        throw std::runtime_error("Shader #include nesting is too deep");
+    }
+    std::istringstream lines(source);
+    std::string line;
+    std::string result;
+    while (std::getline(lines, line)) {
+        auto start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+            auto open = line.find('"', start);
+            auto close = line.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos) {
+                throw std::runtime_error("Malformed shader #include: " + line);
+            }
+            auto includePath = directory / line.substr(open + 1, close - open - 1);
+            std::ifstream includeFile(includePath);
+            if (!includeFile) {
+                throw std::runtime_error("Failed to locate shader include " + includePath.string());
+            }
+            std::stringstream includeStream;
+            includeStream << includeFile.rdbuf();
+            result += resolveIncludes(includeStream.str(), includePath.parent_path(), depth + 1);
+        }
+        else {
+            result += line;
+        }
+        result += "\n";
+    }
+    return result;
+}
+
+ShaderProgram ShaderProgram::variant(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+    const ShaderDefines& defines)
+{
+    // One program per (vertex, fragment, define set). ShaderDefines is ordered, so equal sets
+    // always produce the same key.
+    static std::unordered_map<std::string, ShaderProgram> compiledVariants;
+
+    std::string key = vertexShaderPath + "|" + fragmentShaderPath;
+    for (auto& define : defines) {
+        key += "|" + define.first + "=" + define.second;
+    }
+
+    auto existing = compiledVariants.find(key);
+    if (existing != compiledVariants.end()) {
+        return existing->second;
+    }
+    ShaderProgram program;
+    program.load(vertexShaderPath, fragmentShaderPath, defines);
+    compiledVariants.insert(std::make_pair(key, program));
+    return program;
+}
+
 void ShaderProgram::load(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
+{
+    load(vertexShaderPath, fragmentShaderPath, ShaderDefines());
+}
+
+void ShaderProgram::load(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+    const ShaderDefines& defines)
 {
     std::string vertexCode;
     std::string fragmentCode;
@@ -41,6 +134,12 @@ void ShaderProgram::load(const std::string& vertexShaderPath, const std::string&
         throw std::runtime_error("Failed to locate vertex or fragment shader files");
     }
 
+    // Splice in shared code, then the permutation's defines.
+    vertexCode = injectDefines(resolveIncludes(vertexCode, std::filesystem::path(vertexShaderPath).parent_path()),
+        defines);
+    fragmentCode = injectDefines(resolveIncludes(fragmentCode, std::filesystem::path(fragmentShaderPath).parent_path()),
+        defines);
+
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
 
@@ -139,3 +238,11 @@ void ShaderProgram::setUniform(const std::string& uniformName, const glm::mat4&
 {
     glUniformMatrix4fv(glGetUniformLocation(m_programId, uniformName.c_str()), 1, false, &value[0][0]);
 }
+
+void ShaderProgram::bindUniformBlock(const std::string& blockName, uint32_t bindingPoint)
+{
+    auto index = glGetUniformBlockIndex(m_programId, blockName.c_str());
+    if (index != GL_INVALID_INDEX) {
+        glUniformBlockBinding(m_programId, index, bindingPoint);
+    }
+}
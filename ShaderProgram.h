@@ -1,12 +1,33 @@
 #pragma once
 #include <glm/ext.hpp>
+#include <map>
 #include <string>
+
+/**
+ * @brief A set of preprocessor definitions (name -> value) to inject into a shader's source.
+ * Shaders that support permutations guard their optional work with these names.
+ */
+using ShaderDefines = std::map<std::string, std::string>;
+
 class ShaderProgram {
 	uint32_t m_programId;
 
 public:
 	ShaderProgram();
 	void load(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+	/**
+	 * @brief Loads and links the given shaders, inserting a #define for each entry of the
+	 * given set directly after the #version line of both stages.
+	 */
+	void load(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+		const ShaderDefines& defines);
+
+	/**
+	 * @brief Gets the variant of the given shaders compiled with the given defines. Each
+	 * distinct combination is compiled once; later calls return the cached program.
+	 */
+	static ShaderProgram variant(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+		const ShaderDefines& defines);
 
 	void activate();
 
@@ -19,4 +40,10 @@ public:
 	void setUniform(const std::string& uniformName, const glm::mat2& value);
 	void setUniform(const std::string& uniformName, const glm::mat3& value);
 	void setUniform(const std::string& uniformName, const glm::mat4& value);
-};
\ No newline at end of file
+
+	/**
+	 * @brief Connects the named uniform block to a uniform buffer binding point. Does nothing if
+	 * the program has no such block.
+	 */
+	void bindUniformBlock(const std::string& blockName, uint32_t bindingPoint);
+};
@@ -0,0 +1,90 @@
+#include "Skeleton.h"
+#include <cmath>
+#include <stdexcept>
+#include <glm/gtc/matrix_transform.hpp>
+
+int32_t Skeleton::addNode(const std::string& name, int32_t parent, const glm::mat4& bindTransform) {
+	int32_t index = static_cast<int32_t>(m_nodes.size());
+	m_nodes.push_back(SkeletonNode{ name, parent, bindTransform, -1 });
+	m_nodeIndices.emplace(name, index);
+	return index;
+}
+
+int32_t Skeleton::addBone(const std::string& name, const glm::mat4& offset) {
+	int32_t node = findNode(name);
+	if (node < 0) {
+		return -1;
+	}
+	if (m_nodes[node].bone >= 0) {
+		return m_nodes[node].bone;
+	}
+	if (m_boneOffsets.size() >= MAX_BONES) {
+		throw std::runtime_error("Bone " + name + " is past the skeleton's limit of " + std::to_string(MAX_BONES)
+			+ " bones");
+	}
+	m_nodes[node].bone = static_cast<int32_t>(m_boneOffsets.size());
+	m_boneOffsets.push_back(offset);
+	return m_nodes[node].bone;
+}
+
+int32_t Skeleton::findNode(const std::string& name) const {
+	auto found = m_nodeIndices.find(name);
+	return found == m_nodeIndices.end() ? -1 : found->second;
+}
+
+void Skeleton::setGlobalInverse(const glm::mat4& globalInverse) {
+	m_globalInverse = globalInverse;
+}
+
+const std::vector<SkeletonNode>& Skeleton::nodes() const {
+	return m_nodes;
+}
+
+size_t Skeleton::boneCount() const {
+	return m_boneOffsets.size();
+}
+
+void Skeleton::bindPose(std::vector<glm::mat4>& localTransforms) const {
+	localTransforms.resize(m_nodes.size());
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		localTransforms[i] = m_nodes[i].bindTransform;
+	}
+}
+
+void Skeleton::computeBoneMatrices(const std::vector<glm::mat4>& localTransforms,
+	std::vector<glm::mat4>& boneMatrices) const {
+	m_globalTransforms.resize(m_nodes.size());
+	boneMatrices.resize(m_boneOffsets.size());
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		auto& node = m_nodes[i];
+		m_globalTransforms[i] = node.parent < 0 ? localTransforms[i]
+			: m_globalTransforms[node.parent] * localTransforms[i];
+		if (node.bone >= 0) {
+			boneMatrices[node.bone] = m_globalInverse * m_globalTransforms[i] * m_boneOffsets[node.bone];
+		}
+	}
+}
+
+NodeChannel& SkeletalClip::addChannel(int32_t node) {
+	m_channels.push_back(NodeChannel{ node });
+	return m_channels.back();
+}
+
+void SkeletalClip::sample(float_t time, std::vector<glm::mat4>& localTransforms) const {
+	if (m_duration > 0) {
+		time = std::fmod(time, m_duration);
+	}
+	for (auto& channel : m_channels) {
+		glm::mat4 transform(1.0f);
+		if (!channel.position.empty()) {
+			transform = glm::translate(transform, channel.position.sample(time));
+		}
+		if (!channel.rotation.empty()) {
+			transform = transform * glm::mat4_cast(channel.rotation.sample(time));
+		}
+		if (!channel.scale.empty()) {
+			transform = glm::scale(transform, channel.scale.sample(time));
+		}
+		localTransforms[channel.node] = transform;
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "KeyframeTrack.h"
+
+/**
+ * @brief One node of an imported model's hierarchy. Nodes that deform vertices are bones.
+ */
+struct SkeletonNode {
+	std::string name;
+	// The index of the parent node, or -1 for the root. Always less than this node's index.
+	int32_t parent;
+	// The node's transform relative to its parent when not animated.
+	glm::mat4 bindTransform;
+	// The index of the bone this node drives, or -1 if it drives none.
+	int32_t bone;
+};
+
+/**
+ * @brief The node hierarchy of a skinned model, and the bones that vertices are weighted to.
+ * Nodes are stored parents-first, so a single forward pass computes every global transform.
+ */
+class Skeleton {
+private:
+	std::vector<SkeletonNode> m_nodes;
+	std::unordered_map<std::string, int32_t> m_nodeIndices;
+	// Per bone: the transform from the mesh's space to the bone's space in the bind pose.
+	std::vector<glm::mat4> m_boneOffsets;
+	// The inverse of the root's transform, so the root's placement is left to the Object3D.
+	glm::mat4 m_globalInverse;
+
+	// Scratch for computeBoneMatrices.
+	mutable std::vector<glm::mat4> m_globalTransforms;
+
+public:
+	/**
+	 * @brief The most bones a skeleton may have: the mat4s that fit in a 16 KB uniform block,
+	 * the size every OpenGL implementation supports. The skinning shader is compiled for each
+	 * model's own bone count (see SkinnedModel::shaderDefines).
+	 */
+	static const size_t MAX_BONES = 256;
+
+	Skeleton() : m_globalInverse(1.0f) {}
+
+	/**
+	 * @brief Adds a node under the given parent, which must already be in the skeleton.
+	 * @return the new node's index.
+	 */
+	int32_t addNode(const std::string& name, int32_t parent, const glm::mat4& bindTransform);
+
+	/**
+	 * @brief Makes the named node a bone with the given offset matrix, if it is not one already.
+	 * @return the bone's index, or -1 if there is no such node.
+	 * @throws std::runtime_error if the skeleton already has MAX_BONES bones.
+	 */
+	int32_t addBone(const std::string& name, const glm::mat4& offset);
+
+	/**
+	 * @brief The index of the named node, or -1.
+	 */
+	int32_t findNode(const std::string& name) const;
+
+	void setGlobalInverse(const glm::mat4& globalInverse);
+
+	const std::vector<SkeletonNode>& nodes() const;
+	size_t boneCount() const;
+
+	/**
+	 * @brief Fills localTransforms with every node's bind transform, as a starting pose.
+	 */
+	void bindPose(std::vector<glm::mat4>& localTransforms) const;
+
+	/**
+	 * @brief Computes the skinning matrix of every bone from the nodes' local transforms.
+	 */
+	void computeBoneMatrices(const std::vector<glm::mat4>& localTransforms, std::vector<glm::mat4>& boneMatrices) const;
+};
+
+/**
+ * @brief The keyframes of one node in a SkeletalClip.
+ */
+struct NodeChannel {
+	int32_t node;
+	KeyframeTrack<glm::vec3> position;
+	KeyframeTrack<glm::quat> rotation;
+	KeyframeTrack<glm::vec3> scale;
+};
+
+/**
+ * @brief A skeletal animation: keyframe tracks for some of a skeleton's nodes, sampled by time.
+ * Nodes without a channel keep their bind transform.
+ */
+class SkeletalClip {
+private:
+	std::string m_name;
+	float_t m_duration;
+	std::vector<NodeChannel> m_channels;
+
+public:
+	SkeletalClip(const std::string& name, float_t duration) : m_name(name), m_duration(duration) {}
+
+	const std::string& name() const { return m_name; }
+	float_t duration() const { return m_duration; }
+
+	/**
+	 * @brief Adds an empty channel for the given node, to be filled with keys.
+	 */
+	NodeChannel& addChannel(int32_t node);
+
+	/**
+	 * @brief Writes the local transform of every animated node at the given time, in seconds.
+	 * Times past the end of the clip wrap around.
+	 */
+	void sample(float_t time, std::vector<glm::mat4>& localTransforms) const;
+};
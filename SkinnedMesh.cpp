@@ -0,0 +1,157 @@
+#include "SkinnedMesh.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+void SkinnedVertex3D::addBone(int32_t bone, float_t weight) {
+	size_t weakest = 0;
+	for (size_t i = 0; i < BONES_PER_VERTEX; i++) {
+		if (boneWeights[i] == 0) {
+			boneIds[i] = bone;
+			boneWeights[i] = weight;
+			return;
+		}
+		if (boneWeights[i] < boneWeights[weakest]) {
+			weakest = i;
+		}
+	}
+	if (weight > boneWeights[weakest]) {
+		boneIds[weakest] = bone;
+		boneWeights[weakest] = weight;
+	}
+}
+
+void SkinnedVertex3D::normalizeWeights() {
+	float_t total = 0;
+	for (size_t i = 0; i < BONES_PER_VERTEX; i++) {
+		total += boneWeights[i];
+	}
+	if (total > 0) {
+		for (size_t i = 0; i < BONES_PER_VERTEX; i++) {
+			boneWeights[i] /= total;
+		}
+	}
+}
+
+SkinnedMesh3D::SkinnedMesh3D(std::vector<SkinnedVertex3D>&& vertices, std::vector<uint32_t>&& faces,
+	std::vector<Texture>&& textures)
+	: m_textures(textures), m_vertexCount(vertices.size()), m_faceCount(faces.size()) {
+
+	// The same vertex cache and overdraw ordering as Mesh3D, in the bind pose.
+	std::vector<glm::vec3> positions;
+	positions.reserve(vertices.size());
+	for (auto& v : vertices) {
+		positions.emplace_back(v.x, v.y, v.z);
+	}
+	optimizeTriangleOrder(positions, faces);
+	reorderVertices(vertices, optimizeVertexFetch(faces, vertices.size()));
+
+	glGenVertexArrays(1, &m_vao);
+	glBindVertexArray(m_vao);
+
+	uint32_t vbo;
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SkinnedVertex3D), &vertices[0], GL_STATIC_DRAW);
+
+	// Attributes 0-2 match Mesh3D: position, normal, texture coordinates.
+	glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(SkinnedVertex3D), (void*)offsetof(SkinnedVertex3D, x));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(SkinnedVertex3D), (void*)offsetof(SkinnedVertex3D, nx));
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(SkinnedVertex3D), (void*)offsetof(SkinnedVertex3D, u));
+	glEnableVertexAttribArray(2);
+
+	// Attribute 3 is the bone indices, which must stay integers; attribute 4 is their weights.
+	glVertexAttribIPointer(3, BONES_PER_VERTEX, GL_INT, sizeof(SkinnedVertex3D),
+		(void*)offsetof(SkinnedVertex3D, boneIds));
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(4, BONES_PER_VERTEX, GL_FLOAT, false, sizeof(SkinnedVertex3D),
+		(void*)offsetof(SkinnedVertex3D, boneWeights));
+	glEnableVertexAttribArray(4);
+
+	uint32_t ebo;
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, faces.size() * sizeof(uint32_t), &faces[0], GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+}
+
+void SkinnedMesh3D::render(sf::RenderWindow& window, ShaderProgram& program) const {
+	glBindVertexArray(m_vao);
+	for (auto i = 0; i < m_textures.size(); i++) {
+		program.setUniform(m_textures[i].samplerName, i);
+		glActiveTexture(GL_TEXTURE0 + i);
+		glBindTexture(GL_TEXTURE_2D, m_textures[i].textureId);
+	}
+	glDrawElements(GL_TRIANGLES, m_faceCount, GL_UNSIGNED_INT, nullptr);
+	glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+SkinnedModel::SkinnedModel(std::vector<SkinnedMesh3D>&& meshes, Skeleton&& skeleton,
+	std::vector<SkeletalClip>&& clips)
+	: m_meshes(std::move(meshes)), m_skeleton(std::move(skeleton)), m_clips(std::move(clips)) {
+	// The buffer holds one matrix per bone, the size of the shader's block when compiled with
+	// shaderDefines(). A block cannot be empty, so a model without bones still gets one.
+	glGenBuffers(1, &m_boneBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_boneBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, std::max<size_t>(1, m_skeleton.boneCount()) * sizeof(glm::mat4), nullptr,
+		GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	bindPose();
+}
+
+ShaderDefines SkinnedModel::shaderDefines() const {
+	return ShaderDefines{ { "MAX_BONES", std::to_string(std::max<size_t>(1, m_skeleton.boneCount())) } };
+}
+
+const Skeleton& SkinnedModel::skeleton() const {
+	return m_skeleton;
+}
+
+const std::vector<SkeletalClip>& SkinnedModel::clips() const {
+	return m_clips;
+}
+
+int32_t SkinnedModel::findClip(const std::string& name) const {
+	for (size_t i = 0; i < m_clips.size(); i++) {
+		if (m_clips[i].name() == name) {
+			return static_cast<int32_t>(i);
+		}
+	}
+	return -1;
+}
+
+void SkinnedModel::pose(size_t clip, float_t time) {
+	m_skeleton.bindPose(m_localTransforms);
+	m_clips[clip].sample(time, m_localTransforms);
+	uploadBones();
+}
+
+void SkinnedModel::bindPose() {
+	m_skeleton.bindPose(m_localTransforms);
+	uploadBones();
+}
+
+void SkinnedModel::uploadBones() {
+	m_skeleton.computeBoneMatrices(m_localTransforms, m_boneMatrices);
+	if (m_boneMatrices.empty()) {
+		return;
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_boneBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, m_boneMatrices.size() * sizeof(glm::mat4), &m_boneMatrices[0]);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void SkinnedModel::render(sf::RenderWindow& window, ShaderProgram& program, const glm::mat4& model) const {
+	program.bindUniformBlock("Bones", BONE_BINDING);
+	glBindBufferBase(GL_UNIFORM_BUFFER, BONE_BINDING, m_boneBuffer);
+	program.setUniform("model", model);
+	program.setUniform("normalMatrix", glm::transpose(glm::inverse(glm::mat3(model))));
+	for (auto& mesh : m_meshes) {
+		mesh.render(window, program);
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <glm/glm.hpp>
+#include <glad/glad.h>
+#include "ShaderProgram.h"
+#include "Texture.h"
+#include "Skeleton.h"
+
+/**
+ * @brief The most bones a single vertex can be weighted to.
+ */
+const size_t BONES_PER_VERTEX = 4;
+
+/**
+ * @brief A Vertex3D extended with the bones that move it and how strongly each one does.
+ */
+struct SkinnedVertex3D {
+	float_t x;
+	float_t y;
+	float_t z;
+
+	float_t nx;
+	float_t ny;
+	float_t nz;
+
+	float_t u;
+	float_t v;
+
+	int32_t boneIds[BONES_PER_VERTEX];
+	float_t boneWeights[BONES_PER_VERTEX];
+
+	SkinnedVertex3D(float_t px, float_t py, float_t pz, float_t normX, float_t normY, float_t normZ,
+		float_t texU, float_t texV) :
+		x(px), y(py), z(pz), nx(normX), ny(normY), nz(normZ), u(texU), v(texV),
+		boneIds{ 0, 0, 0, 0 }, boneWeights{ 0, 0, 0, 0 } {}
+
+	/**
+	 * @brief Adds a bone influence. Once all slots are used, the new bone replaces the weakest
+	 * influence if it is stronger.
+	 */
+	void addBone(int32_t bone, float_t weight);
+
+	/**
+	 * @brief Scales the weights to sum to 1, if the vertex has any.
+	 */
+	void normalizeWeights();
+};
+
+/**
+ * @brief A mesh whose vertices are deformed by a skeleton on the GPU, by shaders/skinning.vert.
+ */
+class SkinnedMesh3D {
+private:
+	uint32_t m_vao;
+	std::vector<Texture> m_textures;
+	size_t m_vertexCount;
+	size_t m_faceCount;
+
+public:
+	SkinnedMesh3D() = delete;
+
+	SkinnedMesh3D(std::vector<SkinnedVertex3D>&& vertices, std::vector<uint32_t>&& faces,
+		std::vector<Texture>&& textures);
+
+	/**
+	 * @brief Renders the mesh to the given context.
+	 */
+	void render(sf::RenderWindow& window, ShaderProgram& program) const;
+};
+
+/**
+ * @brief The meshes of a skinned model, the skeleton that deforms them, and its animations.
+ * Posing samples a clip on the CPU, once per model, and uploads the bone matrices to a uniform
+ * buffer; every mesh of the model is then drawn once, deformed entirely in the vertex shader.
+ */
+class SkinnedModel {
+private:
+	std::vector<SkinnedMesh3D> m_meshes;
+	Skeleton m_skeleton;
+	std::vector<SkeletalClip> m_clips;
+	// The current pose: the local transform of each node, and the matrix of each bone.
+	std::vector<glm::mat4> m_localTransforms;
+	std::vector<glm::mat4> m_boneMatrices;
+	uint32_t m_boneBuffer;
+
+	void uploadBones();
+
+public:
+	/**
+	 * @brief The uniform buffer binding point of the "Bones" block in shaders/skinning.vert.
+	 */
+	static const uint32_t BONE_BINDING = 0;
+
+	SkinnedModel(std::vector<SkinnedMesh3D>&& meshes, Skeleton&& skeleton, std::vector<SkeletalClip>&& clips);
+
+	/**
+	 * @brief The defines to compile shaders/skinning.vert with for this model: MAX_BONES sizes the
+	 * "Bones" block to the skeleton's bone count.
+	 */
+	ShaderDefines shaderDefines() const;
+
+	const Skeleton& skeleton() const;
+	const std::vector<SkeletalClip>& clips() const;
+
+	/**
+	 * @brief The index of the named clip, or -1.
+	 */
+	int32_t findClip(const std::string& name) const;
+
+	/**
+	 * @brief Poses the model as the given clip has it at the given time, in seconds.
+	 */
+	void pose(size_t clip, float_t time);
+
+	/**
+	 * @brief Returns the model to its bind pose.
+	 */
+	void bindPose();
+
+	/**
+	 * @brief Renders the model in its current pose, with the given model matrix.
+	 */
+	void render(sf::RenderWindow& window, ShaderProgram& program, const glm::mat4& model) const;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief A container that hands out stable handles to its values. Values are stored densely, so
+ * iterating them is as fast as iterating a vector, and inserting or erasing is O(1) without
+ * invalidating any other value's handle. Each slot counts how many times it has been reused, so
+ * a handle to an erased value is recognized as stale rather than silently reaching whatever value
+ * took its place.
+ *
+ * Pointers and references to values are NOT stable across inserts and erases; keep handles.
+ */
+template <typename T>
+class SlotMap {
+public:
+	/**
+	 * @brief Identifies a value in the map. A default-constructed handle refers to nothing.
+	 */
+	struct Handle {
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+
+		bool operator==(const Handle& other) const {
+			return index == other.index && generation == other.generation;
+		}
+		bool operator!=(const Handle& other) const { return !(*this == other); }
+	};
+
+private:
+	struct Slot {
+		// While live, the position of the slot's value in m_values; while free, the next free slot.
+		uint32_t dense;
+		uint32_t generation;
+	};
+
+	std::vector<Slot> m_slots;
+	std::vector<T> m_values;
+	// The slot that owns each value, parallel to m_values.
+	std::vector<uint32_t> m_valueSlots;
+	uint32_t m_freeHead = UINT32_MAX;
+
+	const Slot* liveSlot(const Handle& handle) const {
+		if (handle.index >= m_slots.size()) {
+			return nullptr;
+		}
+		const Slot& slot = m_slots[handle.index];
+		return slot.generation == handle.generation ? &slot : nullptr;
+	}
+
+public:
+	/**
+	 * @brief Adds a value, reusing a free slot if there is one.
+	 */
+	Handle insert(T&& value) {
+		uint32_t index;
+		if (m_freeHead != UINT32_MAX) {
+			index = m_freeHead;
+			m_freeHead = m_slots[index].dense;
+		}
+		else {
+			index = static_cast<uint32_t>(m_slots.size());
+			m_slots.push_back(Slot{ 0, 0 });
+		}
+		m_slots[index].dense = static_cast<uint32_t>(m_values.size());
+		m_values.push_back(std::move(value));
+		m_valueSlots.push_back(index);
+		return Handle{ index, m_slots[index].generation };
+	}
+
+	/**
+	 * @brief Removes the value, if the handle is still live. The last value moves into the gap.
+	 * @return whether a value was removed.
+	 */
+	bool erase(const Handle& handle) {
+		return erase(handle, nullptr);
+	}
+
+	/**
+	 * @brief Removes the value like erase(handle), but moves it onto the end of removed instead
+	 * of destroying it, for values something else may still be using.
+	 */
+	bool erase(const Handle& handle, std::vector<T>& removed) {
+		return erase(handle, &removed);
+	}
+
+private:
+	bool erase(const Handle& handle, std::vector<T>* removed) {
+		if (liveSlot(handle) == nullptr) {
+			return false;
+		}
+		Slot& slot = m_slots[handle.index];
+		uint32_t dense = slot.dense;
+		if (removed != nullptr) {
+			removed->push_back(std::move(m_values[dense]));
+		}
+		uint32_t last = static_cast<uint32_t>(m_values.size() - 1);
+		if (dense != last) {
+			m_values[dense] = std::move(m_values[last]);
+			m_valueSlots[dense] = m_valueSlots[last];
+			m_slots[m_valueSlots[dense]].dense = dense;
+		}
+		m_values.pop_back();
+		m_valueSlots.pop_back();
+
+		// Invalidate every existing handle to the slot, and put it on the free list.
+		slot.generation++;
+		slot.dense = m_freeHead;
+		m_freeHead = handle.index;
+		return true;
+	}
+
+public:
+	bool contains(const Handle& handle) const {
+		return liveSlot(handle) != nullptr;
+	}
+
+	/**
+	 * @brief The handle's value, or nullptr if the handle is stale.
+	 */
+	T* get(const Handle& handle) {
+		const Slot* slot = liveSlot(handle);
+		return slot == nullptr ? nullptr : &m_values[slot->dense];
+	}
+
+	const T* get(const Handle& handle) const {
+		const Slot* slot = liveSlot(handle);
+		return slot == nullptr ? nullptr : &m_values[slot->dense];
+	}
+
+	/**
+	 * @brief The handle's value. Throws if the handle is stale.
+	 */
+	T& operator[](const Handle& handle) {
+		T* value = get(handle);
+		if (value == nullptr) {
+			throw std::runtime_error("Stale slot map handle");
+		}
+		return *value;
+	}
+
+	const T& operator[](const Handle& handle) const {
+		const T* value = get(handle);
+		if (value == nullptr) {
+			throw std::runtime_error("Stale slot map handle");
+		}
+		return *value;
+	}
+
+	size_t size() const { return m_values.size(); }
+	bool empty() const { return m_values.empty(); }
+
+	/**
+	 * @brief The values, densely packed in no particular order.
+	 */
+	std::vector<T>& values() { return m_values; }
+	const std::vector<T>& values() const { return m_values; }
+
+	typename std::vector<T>::iterator begin() { return m_values.begin(); }
+	typename std::vector<T>::iterator end() { return m_values.end(); }
+	typename std::vector<T>::const_iterator begin() const { return m_values.begin(); }
+	typename std::vector<T>::const_iterator end() const { return m_values.end(); }
+};
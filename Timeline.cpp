@@ -0,0 +1,96 @@
+#include "Timeline.h"
+#include <algorithm>
+
+float_t TimelineNode::duration() const {
+	float_t total = 0;
+	switch (m_kind) {
+	case Kind::Clip:
+		return m_animation->duration();
+	case Kind::Delay:
+		return m_delay;
+	case Kind::Sequence:
+		for (auto& child : m_children) {
+			total += child.duration();
+		}
+		return total;
+	case Kind::Parallel:
+		for (auto& child : m_children) {
+			total = std::max(total, child.duration());
+		}
+		return total;
+	}
+	return total;
+}
+
+float_t Timeline::schedule(TimelineNode& node, float_t start) {
+	switch (node.m_kind) {
+	case TimelineNode::Kind::Clip: {
+		float_t end = start + node.m_animation->duration();
+		m_entries.push_back(Entry{ start, end, std::move(node.m_animation) });
+		return end;
+	}
+	case TimelineNode::Kind::Delay:
+		return start + node.m_delay;
+	case TimelineNode::Kind::Sequence: {
+		float_t time = start;
+		for (auto& child : node.m_children) {
+			time = schedule(child, time);
+		}
+		return time;
+	}
+	case TimelineNode::Kind::Parallel: {
+		float_t end = start;
+		for (auto& child : node.m_children) {
+			end = std::max(end, schedule(child, start));
+		}
+		return end;
+	}
+	}
+	return start;
+}
+
+float_t Timeline::add(TimelineNode node, float_t start) {
+	float_t end = schedule(node, start);
+	m_duration = std::max(m_duration, end);
+	m_sorted = false;
+	return end;
+}
+
+void Timeline::start() {
+	if (!m_sorted) {
+		// A stable sort keeps entries that start together in the order they were added, so later
+		// animations of the same object still apply last.
+		std::stable_sort(m_entries.begin(), m_entries.end(),
+			[](const Entry& a, const Entry& b) { return a.start < b.start; });
+		m_sorted = true;
+	}
+	m_currentTime = 0;
+	m_nextEntry = 0;
+	m_active.clear();
+}
+
+void Timeline::tick(float_t dt, ObjectStore& objects) {
+	float_t from = m_currentTime;
+	float_t to = from + dt;
+	m_currentTime = to;
+
+	// Pop every entry whose start time has arrived.
+	while (m_nextEntry < m_entries.size() && m_entries[m_nextEntry].start <= to) {
+		m_entries[m_nextEntry].animation->start(objects);
+		m_active.push_back(m_nextEntry);
+		m_nextEntry++;
+	}
+
+	// Advance each active animation by the part of this tick inside its window, so it receives
+	// exactly its duration in total however the frames fall.
+	for (auto index : m_active) {
+		auto& entry = m_entries[index];
+		float_t overlap = std::min(to, entry.end) - std::max(from, entry.start);
+		if (overlap > 0) {
+			entry.animation->tick(overlap, objects);
+		}
+	}
+
+	m_active.erase(std::remove_if(m_active.begin(), m_active.end(),
+		[this, to](size_t index) { return m_entries[index].end <= to; }), m_active.end());
+}
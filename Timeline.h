@@ -0,0 +1,153 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Animation.h"
+#include "ObjectStore.h"
+
+/**
+ * @brief A piece of a Timeline: a single animation, a wait, or a group of nodes played one after
+ * another (sequence) or all at once (parallel). Groups nest to any depth.
+ */
+class TimelineNode {
+public:
+	enum class Kind { Clip, Delay, Sequence, Parallel };
+
+private:
+	Kind m_kind;
+	float_t m_delay;
+	std::unique_ptr<Animation> m_animation;
+	std::vector<TimelineNode> m_children;
+
+	TimelineNode(Kind kind) : m_kind(kind), m_delay(0) {}
+
+	friend class Timeline;
+
+public:
+	/**
+	 * @brief A node that plays the given animation once.
+	 */
+	static TimelineNode clip(std::unique_ptr<Animation> animation) {
+		TimelineNode node(Kind::Clip);
+		node.m_animation = std::move(animation);
+		return node;
+	}
+
+	/**
+	 * @brief A node that constructs and plays an animation of type T from the given arguments.
+	 */
+	template <typename T, typename... Args>
+	static TimelineNode clip(Args&&... args) {
+		return clip(std::make_unique<T>(std::forward<Args>(args)...));
+	}
+
+	/**
+	 * @brief A node that does nothing for the given number of seconds.
+	 */
+	static TimelineNode delay(float_t seconds) {
+		TimelineNode node(Kind::Delay);
+		node.m_delay = seconds;
+		return node;
+	}
+
+	/**
+	 * @brief A node that plays its children one after another.
+	 */
+	template <typename... Nodes>
+	static TimelineNode sequence(Nodes&&... children) {
+		TimelineNode node(Kind::Sequence);
+		(node.add(std::forward<Nodes>(children)), ...);
+		return node;
+	}
+
+	/**
+	 * @brief A node that starts all its children together, and ends when the longest ends.
+	 */
+	template <typename... Nodes>
+	static TimelineNode parallel(Nodes&&... children) {
+		TimelineNode node(Kind::Parallel);
+		(node.add(std::forward<Nodes>(children)), ...);
+		return node;
+	}
+
+	/**
+	 * @brief Appends a child to a sequence or parallel node.
+	 */
+	TimelineNode& add(TimelineNode child) {
+		m_children.push_back(std::move(child));
+		return *this;
+	}
+
+	Kind kind() const { return m_kind; }
+
+	/**
+	 * @brief How long the node takes to play, in seconds.
+	 */
+	float_t duration() const;
+};
+
+/**
+ * @brief Plays animations on a shared clock, each at a fixed start time. Nodes added to the
+ * timeline are flattened into a table of (start, end, animation) entries sorted by start time.
+ * That table is the timeline's event queue: each tick pops the entries whose start time has
+ * arrived into a small active list, and retires them once they end, so a frame only touches
+ * the animations that are actually playing, however many are scheduled.
+ */
+class Timeline {
+private:
+	struct Entry {
+		float_t start;
+		float_t end;
+		std::unique_ptr<Animation> animation;
+	};
+
+	std::vector<Entry> m_entries;
+	// The first entry in m_entries that has not started yet.
+	size_t m_nextEntry;
+	// Indices of the entries that have started but not yet ended, in start order.
+	std::vector<size_t> m_active;
+	bool m_sorted;
+	float_t m_currentTime;
+	float_t m_duration;
+
+	/**
+	 * @brief Adds the node's animations to the table, starting at the given time.
+	 * @return the node's end time.
+	 */
+	float_t schedule(TimelineNode& node, float_t start);
+
+public:
+	Timeline() : m_nextEntry(0), m_sorted(true), m_currentTime(0), m_duration(0) {}
+
+	/**
+	 * @brief Schedules the node to start at the given time, in seconds from the timeline's start.
+	 * Nodes must be added before start().
+	 * @return the time at which the node ends.
+	 */
+	float_t add(TimelineNode node, float_t start = 0);
+
+	/**
+	 * @brief The time at which the last scheduled animation ends.
+	 */
+	float_t duration() const { return m_duration; }
+
+	/**
+	 * @brief How many animations are playing right now.
+	 */
+	size_t activeCount() const { return m_active.size(); }
+
+	/**
+	 * @brief Whether every scheduled animation has finished.
+	 */
+	bool finished() const { return m_active.empty() && m_nextEntry >= m_entries.size(); }
+
+	/**
+	 * @brief Starts the timeline's clock at zero.
+	 */
+	void start();
+
+	/**
+	 * @brief Advances the timeline by the given time interval, in seconds, applying its
+	 * animations to the objects in the given store.
+	 */
+	void tick(float_t dt, ObjectStore& objects);
+};
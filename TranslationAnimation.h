@@ -9,7 +9,7 @@ private:
 		object().move(m_translation * dt);
 	}
 public:
-	TranslationAnimation(Object3D& object, float_t duration, 
+	TranslationAnimation(ObjectRef object, float_t duration, 
 		const glm::vec3& totalMovement) :
-		Animation(object, duration), m_translation(totalMovement / duration) {}
+		Animation(std::move(object), duration), m_translation(totalMovement / duration) {}
 };
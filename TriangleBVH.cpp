@@ -0,0 +1,445 @@
+#include "TriangleBVH.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+	float_t surfaceArea(const BoundingBox& box) {
+		if (box.isEmpty()) {
+			return 0;
+		}
+		glm::vec3 size = box.max - box.min;
+		return 2 * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	glm::vec3 centroid(const CollisionTriangle& triangle) {
+		return (triangle.a + triangle.b + triangle.c) * (1.0f / 3);
+	}
+
+	BoundingBox triangleBounds(const CollisionTriangle& triangle) {
+		BoundingBox bounds;
+		bounds.expand(triangle.a);
+		bounds.expand(triangle.b);
+		bounds.expand(triangle.c);
+		return bounds;
+	}
+
+	glm::vec3 reciprocal(const glm::vec3& v) {
+		// A zero component becomes a huge value rather than infinity, so the slab test never
+		// multiplies infinity by zero.
+		auto inverse = [](float_t x) { return std::abs(x) > 1e-20f ? 1 / x : std::copysign(1e20f, x); };
+		return glm::vec3(inverse(v.x), inverse(v.y), inverse(v.z));
+	}
+
+	// A traversal's stack holds at most one node per level of the tree, plus one. build() makes
+	// nodes at MAX_DEPTH leaves, however many triangles they hold, so the stack never overflows.
+	const uint32_t STACK_SIZE = 64;
+	const uint32_t MAX_DEPTH = STACK_SIZE - 1;
+
+	// Version 2 added the key, and capped the depth.
+	const char BVH_MAGIC[4] = { 'B', 'V', 'H', '2' };
+}
+
+TriangleBVH::TriangleBVH(std::vector<CollisionTriangle>&& triangles) : m_triangles(std::move(triangles)) {
+	build();
+}
+
+TriangleBVH TriangleBVH::fromIndexed(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices) {
+	std::vector<CollisionTriangle> triangles;
+	triangles.reserve(indices.size() / 3);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		triangles.push_back(CollisionTriangle{ vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]] });
+	}
+	return TriangleBVH(std::move(triangles));
+}
+
+void TriangleBVH::build() {
+	m_nodes.clear();
+	if (m_triangles.empty()) {
+		return;
+	}
+	std::vector<glm::vec3> centroids;
+	std::vector<BoundingBox> boxes;
+	centroids.reserve(m_triangles.size());
+	boxes.reserve(m_triangles.size());
+	for (auto& triangle : m_triangles) {
+		centroids.push_back(centroid(triangle));
+		boxes.push_back(triangleBounds(triangle));
+	}
+
+	m_nodes.reserve(2 * m_triangles.size());
+	m_nodes.push_back(Node{ BoundingBox(), 0, static_cast<uint32_t>(m_triangles.size()) });
+	// Nodes to split, with their depths.
+	std::vector<std::pair<uint32_t, uint32_t>> pending = { { 0, 0 } };
+	while (!pending.empty()) {
+		uint32_t index = pending.back().first;
+		uint32_t depth = pending.back().second;
+		pending.pop_back();
+		uint32_t first = m_nodes[index].first;
+		uint32_t count = m_nodes[index].count;
+
+		BoundingBox bounds;
+		BoundingBox centroidBounds;
+		for (uint32_t i = first; i < first + count; i++) {
+			bounds.expand(boxes[i]);
+			centroidBounds.expand(centroids[i]);
+		}
+		m_nodes[index].bounds = bounds;
+		if (count <= 2 || depth >= MAX_DEPTH) {
+			continue;
+		}
+
+		// Bin the centroids along each axis and find the cheapest split between bins.
+		float_t bestCost = std::numeric_limits<float_t>::max();
+		int32_t bestAxis = -1;
+		uint32_t bestSplit = 0;
+		glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+		for (int32_t axis = 0; axis < 3; axis++) {
+			if (extent[axis] <= 0) {
+				continue;
+			}
+			BoundingBox binBounds[BINS];
+			uint32_t binCounts[BINS] = {};
+			float_t scale = BINS / extent[axis];
+			for (uint32_t i = first; i < first + count; i++) {
+				uint32_t bin = std::min(BINS - 1, static_cast<uint32_t>((centroids[i][axis] - centroidBounds.min[axis]) * scale));
+				binCounts[bin]++;
+				binBounds[bin].expand(boxes[i]);
+			}
+			// Sweep from the right to get the area and count right of each split, then from the
+			// left to price each split.
+			float_t rightAreas[BINS];
+			uint32_t rightCounts[BINS];
+			BoundingBox right;
+			uint32_t rightCount = 0;
+			for (uint32_t bin = BINS - 1; bin > 0; bin--) {
+				right.expand(binBounds[bin]);
+				rightCount += binCounts[bin];
+				rightAreas[bin] = surfaceArea(right);
+				rightCounts[bin] = rightCount;
+			}
+			BoundingBox left;
+			uint32_t leftCount = 0;
+			for (uint32_t split = 1; split < BINS; split++) {
+				left.expand(binBounds[split - 1]);
+				leftCount += binCounts[split - 1];
+				if (leftCount == 0 || rightCounts[split] == 0) {
+					continue;
+				}
+				float_t cost = surfaceArea(left) * leftCount + rightAreas[split] * rightCounts[split];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = split;
+				}
+			}
+		}
+
+		// Splitting costs a node visit, weighed here as one triangle test over the node's area.
+		float_t leafCost = surfaceArea(bounds) * count;
+		if (bestAxis < 0 || (bestCost + surfaceArea(bounds) >= leafCost && count <= MAX_LEAF_SIZE)) {
+			continue;
+		}
+
+		// Partition the node's triangles around the split.
+		float_t scale = BINS / extent[bestAxis];
+		uint32_t middle = first;
+		for (uint32_t i = first; i < first + count; i++) {
+			uint32_t bin = std::min(BINS - 1, static_cast<uint32_t>((centroids[i][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+			if (bin < bestSplit) {
+				std::swap(m_triangles[i], m_triangles[middle]);
+				std::swap(centroids[i], centroids[middle]);
+				std::swap(boxes[i], boxes[middle]);
+				middle++;
+			}
+		}
+
+		uint32_t left = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.push_back(Node{ BoundingBox(), first, middle - first });
+		m_nodes.push_back(Node{ BoundingBox(), middle, first + count - middle });
+		m_nodes[index].first = left;
+		m_nodes[index].count = 0;
+		pending.push_back({ left, depth + 1 });
+		pending.push_back({ left + 1, depth + 1 });
+	}
+}
+
+bool TriangleBVH::empty() const {
+	return m_triangles.empty();
+}
+
+size_t TriangleBVH::triangleCount() const {
+	return m_triangles.size();
+}
+
+const std::vector<CollisionTriangle>& TriangleBVH::triangles() const {
+	return m_triangles;
+}
+
+BoundingBox TriangleBVH::bounds() const {
+	return m_nodes.empty() ? BoundingBox() : m_nodes[0].bounds;
+}
+
+bool TriangleBVH::raycast(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance,
+	CastHit& hit) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	glm::vec3 inverseDirection = reciprocal(direction);
+	float_t nearest = maxDistance;
+	bool found = false;
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = m_nodes[stack[--top]];
+		float_t entry;
+		if (!rayBox(origin, inverseDirection, node.bounds, nearest, entry)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				float_t distance;
+				if (rayTriangle(origin, direction, m_triangles[i], distance) && distance <= nearest) {
+					nearest = distance;
+					hit.distance = distance;
+					hit.triangle = i;
+					found = true;
+				}
+			}
+			continue;
+		}
+		// Visit the nearer child first, so hits in it prune the farther one.
+		float_t leftEntry;
+		float_t rightEntry;
+		bool hitsLeft = rayBox(origin, inverseDirection, m_nodes[node.first].bounds, nearest, leftEntry);
+		bool hitsRight = rayBox(origin, inverseDirection, m_nodes[node.first + 1].bounds, nearest, rightEntry);
+		if (top + 2 > STACK_SIZE) {
+			throw std::runtime_error("BVH too deep to traverse");
+		}
+		if (hitsLeft && hitsRight) {
+			bool leftFirst = leftEntry <= rightEntry;
+			stack[top++] = leftFirst ? node.first + 1 : node.first;
+			stack[top++] = leftFirst ? node.first : node.first + 1;
+		}
+		else if (hitsLeft) {
+			stack[top++] = node.first;
+		}
+		else if (hitsRight) {
+			stack[top++] = node.first + 1;
+		}
+	}
+	if (found) {
+		const CollisionTriangle& triangle = m_triangles[hit.triangle];
+		hit.normal = glm::normalize(glm::cross(triangle.b - triangle.a, triangle.c - triangle.a));
+		// Report the side the ray came from.
+		if (glm::dot(hit.normal, direction) > 0) {
+			hit.normal = -hit.normal;
+		}
+	}
+	return found;
+}
+
+bool TriangleBVH::sphereCast(const glm::vec3& start, const glm::vec3& motion, float_t radius, CastHit& hit) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	// A ray along the motion against node bounds grown by the radius.
+	glm::vec3 inverseMotion = reciprocal(motion);
+	float_t nearest = 1;
+	bool found = false;
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = m_nodes[stack[--top]];
+		BoundingBox grown(node.bounds.min - radius, node.bounds.max + radius);
+		float_t entry;
+		if (!rayBox(start, inverseMotion, grown, nearest, entry)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				float_t fraction;
+				glm::vec3 normal;
+				if (sweepSphereTriangle(start, motion, radius, m_triangles[i], fraction, normal) && fraction <= nearest) {
+					nearest = fraction;
+					hit.distance = fraction;
+					hit.normal = normal;
+					hit.triangle = i;
+					found = true;
+				}
+			}
+			continue;
+		}
+		if (top + 2 > STACK_SIZE) {
+			throw std::runtime_error("BVH too deep to traverse");
+		}
+		stack[top++] = node.first + 1;
+		stack[top++] = node.first;
+	}
+	return found;
+}
+
+bool TriangleBVH::closestPoint(const glm::vec3& point, float_t maxDistance, glm::vec3& closest) const {
+	if (m_nodes.empty()) {
+		return false;
+	}
+	float_t best = maxDistance * maxDistance;
+	bool found = false;
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = m_nodes[stack[--top]];
+		if (node.bounds.distanceSquared(point) > best) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				glm::vec3 candidate = closestPointOnTriangle(point, m_triangles[i]);
+				glm::vec3 offset = candidate - point;
+				float_t distance2 = glm::dot(offset, offset);
+				if (distance2 <= best) {
+					best = distance2;
+					closest = candidate;
+					found = true;
+				}
+			}
+			continue;
+		}
+		if (top + 2 > STACK_SIZE) {
+			throw std::runtime_error("BVH too deep to traverse");
+		}
+		// Nearer child last, so it is visited first and tightens the bound for the other.
+		const Node& left = m_nodes[node.first];
+		const Node& right = m_nodes[node.first + 1];
+		bool leftNearer = left.bounds.distanceSquared(point) <= right.bounds.distanceSquared(point);
+		stack[top++] = leftNearer ? node.first + 1 : node.first;
+		stack[top++] = leftNearer ? node.first : node.first + 1;
+	}
+	return found;
+}
+
+void TriangleBVH::overlapSphere(const glm::vec3& center, float_t radius, std::vector<uint32_t>& triangles) const {
+	if (m_nodes.empty()) {
+		return;
+	}
+	float_t radius2 = radius * radius;
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = m_nodes[stack[--top]];
+		if (node.bounds.distanceSquared(center) > radius2) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				glm::vec3 offset = closestPointOnTriangle(center, m_triangles[i]) - center;
+				if (glm::dot(offset, offset) <= radius2) {
+					triangles.push_back(i);
+				}
+			}
+			continue;
+		}
+		if (top + 2 > STACK_SIZE) {
+			throw std::runtime_error("BVH too deep to traverse");
+		}
+		stack[top++] = node.first + 1;
+		stack[top++] = node.first;
+	}
+}
+
+void TriangleBVH::overlapBox(const BoundingBox& box, std::vector<uint32_t>& triangles) const {
+	if (m_nodes.empty()) {
+		return;
+	}
+	uint32_t stack[STACK_SIZE];
+	uint32_t top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = m_nodes[stack[--top]];
+		if (!node.bounds.overlaps(box)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; i++) {
+				if (triangleBounds(m_triangles[i]).overlaps(box)) {
+					triangles.push_back(i);
+				}
+			}
+			continue;
+		}
+		if (top + 2 > STACK_SIZE) {
+			throw std::runtime_error("BVH too deep to traverse");
+		}
+		stack[top++] = node.first + 1;
+		stack[top++] = node.first;
+	}
+}
+
+void TriangleBVH::save(const std::filesystem::path& path, const std::string& key) const {
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Could not write BVH file " + path.string());
+	}
+	uint32_t keyLength = static_cast<uint32_t>(key.size());
+	uint32_t triangleCount = static_cast<uint32_t>(m_triangles.size());
+	uint32_t nodeCount = static_cast<uint32_t>(m_nodes.size());
+	file.write(BVH_MAGIC, sizeof(BVH_MAGIC));
+	file.write(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
+	file.write(key.data(), keyLength);
+	file.write(reinterpret_cast<const char*>(&triangleCount), sizeof(triangleCount));
+	file.write(reinterpret_cast<const char*>(&nodeCount), sizeof(nodeCount));
+	file.write(reinterpret_cast<const char*>(m_triangles.data()), triangleCount * sizeof(CollisionTriangle));
+	file.write(reinterpret_cast<const char*>(m_nodes.data()), nodeCount * sizeof(Node));
+}
+
+/**
+ * @brief Reads a BVH file's header up to its counts. Returns false if it is not a BVH file of
+ * this version.
+ */
+static bool readHeader(std::ifstream& file, std::string& key) {
+	char magic[sizeof(BVH_MAGIC)];
+	uint32_t keyLength;
+	file.read(magic, sizeof(magic));
+	file.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
+	if (!file || !std::equal(magic, magic + sizeof(magic), BVH_MAGIC)) {
+		return false;
+	}
+	key.resize(keyLength);
+	file.read(&key[0], keyLength);
+	return static_cast<bool>(file);
+}
+
+bool TriangleBVH::readKey(const std::filesystem::path& path, std::string& key) {
+	std::ifstream file(path, std::ios::binary);
+	return readHeader(file, key);
+}
+
+TriangleBVH TriangleBVH::load(const std::filesystem::path& path) {
+	std::ifstream file(path, std::ios::binary);
+	std::string key;
+	uint32_t triangleCount;
+	uint32_t nodeCount;
+	if (!readHeader(file, key)) {
+		throw std::runtime_error("Not a BVH file: " + path.string());
+	}
+	file.read(reinterpret_cast<char*>(&triangleCount), sizeof(triangleCount));
+	file.read(reinterpret_cast<char*>(&nodeCount), sizeof(nodeCount));
+	if (!file) {
+		throw std::runtime_error("Truncated BVH file: " + path.string());
+	}
+	TriangleBVH bvh;
+	bvh.m_triangles.resize(triangleCount);
+	bvh.m_nodes.resize(nodeCount);
+	file.read(reinterpret_cast<char*>(bvh.m_triangles.data()), triangleCount * sizeof(CollisionTriangle));
+	file.read(reinterpret_cast<char*>(bvh.m_nodes.data()), nodeCount * sizeof(Node));
+	if (!file) {
+		throw std::runtime_error("Truncated BVH file: " + path.string());
+	}
+	return bvh;
+}
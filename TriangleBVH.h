@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "BoundingBox.h"
+#include "Collision.h"
+
+/**
+ * @brief The nearest surface a ray or sphere cast reached.
+ */
+struct CastHit {
+	// Distance along a ray, or fraction of a sphere cast's motion.
+	float_t distance;
+	glm::vec3 normal;
+	uint32_t triangle;
+};
+
+/**
+ * @brief A bounding volume hierarchy over static triangles, for collision queries against large
+ * level meshes in logarithmic time.
+ *
+ * The tree is built top down. Each node is split where the surface area heuristic estimates
+ * the cheapest traversal: triangle centroids are binned along each axis, and the split between
+ * bins minimizing (left area * left count + right area * right count) wins, unless keeping the
+ * node as a leaf is cheaper. Nodes are stored in one array with siblings adjacent, and triangles
+ * are reordered so each leaf's triangles are contiguous. Nodes deeper than the traversals'
+ * fixed stacks allow are left as leaves, so queries never run out of stack.
+ */
+class TriangleBVH {
+private:
+	struct Node {
+		BoundingBox bounds;
+		// A leaf's first triangle, or an inner node's left child (the right child follows it).
+		uint32_t first;
+		// A leaf's triangle count; 0 for inner nodes.
+		uint32_t count;
+	};
+
+	std::vector<CollisionTriangle> m_triangles;
+	std::vector<Node> m_nodes;
+
+	static const uint32_t BINS = 12;
+	static const uint32_t MAX_LEAF_SIZE = 8;
+
+	void build();
+
+public:
+	/**
+	 * @brief An empty hierarchy, which nothing hits.
+	 */
+	TriangleBVH() = default;
+	explicit TriangleBVH(std::vector<CollisionTriangle>&& triangles);
+
+	/**
+	 * @brief Builds a hierarchy over indexed triangles, three indices per triangle.
+	 */
+	static TriangleBVH fromIndexed(const std::vector<glm::vec3>& vertices, const std::vector<uint32_t>& indices);
+
+	bool empty() const;
+	size_t triangleCount() const;
+	const std::vector<CollisionTriangle>& triangles() const;
+	BoundingBox bounds() const;
+
+	/**
+	 * @brief Finds the nearest triangle hit by a ray within maxDistance. The direction must be
+	 * unit length.
+	 */
+	bool raycast(const glm::vec3& origin, const glm::vec3& direction, float_t maxDistance, CastHit& hit) const;
+
+	/**
+	 * @brief Finds the first triangle face a sphere moving from start by motion touches. The
+	 * hit's distance is the fraction of the motion before contact.
+	 */
+	bool sphereCast(const glm::vec3& start, const glm::vec3& motion, float_t radius, CastHit& hit) const;
+
+	/**
+	 * @brief Finds the point on any triangle nearest to the given point, within maxDistance.
+	 */
+	bool closestPoint(const glm::vec3& point, float_t maxDistance, glm::vec3& closest) const;
+
+	/**
+	 * @brief Appends the indices of the triangles within radius of center.
+	 */
+	void overlapSphere(const glm::vec3& center, float_t radius, std::vector<uint32_t>& triangles) const;
+
+	/**
+	 * @brief Appends the indices of the triangles whose bounds overlap the box.
+	 */
+	void overlapBox(const BoundingBox& box, std::vector<uint32_t>& triangles) const;
+
+	/**
+	 * @brief Writes the built hierarchy to a file, for load() to read without rebuilding. The key
+	 * describes what the hierarchy was built from, so a cache can tell if it is stale.
+	 */
+	void save(const std::filesystem::path& path, const std::string& key = std::string()) const;
+	static TriangleBVH load(const std::filesystem::path& path);
+	/**
+	 * @brief Reads the key a file was saved with. Returns false if the file is missing, or is not
+	 * a BVH file of this version.
+	 */
+	static bool readKey(const std::filesystem::path& path, std::string& key);
+};
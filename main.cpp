@@ -4,14 +4,63 @@ This application renders a textured mesh that was loaded with Assimp.
 
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <thread>
 #include<glad/glad.h>
 
 #include "Mesh3D.h"
 #include "Object3D.h"
 #include "AssimpImport.h"
-#include "Animator.h"
+#include "Timeline.h"
+#include "RotationAnimation.h"
+#include "ClipAnimation.h"
+#include "AnimationSystem.h"
+#include "ObjectStore.h"
 #include "ShaderProgram.h"
 #include "Camera.h"
+#include "CameraPath.h"
+#include "ClusteredLights.h"
+#include "Renderer.h"
+#include "FixedTimestep.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "PhysicsWorld.h"
+#include "CharacterController.h"
+#include "SceneQuery.h"
+#include "PortalCells.h"
+
+// Forward lights every rasterized fragment; Deferred lights each screen pixel once.
+const Renderer::Mode RENDER_MODE = Renderer::Mode::Forward;
+// In Forward mode, fill the depth buffer first so only visible fragments are lit.
+const bool DEPTH_PREPASS = true;
+// Skip meshes hidden behind nearer ones, such as the rooms of the level behind its walls.
+const bool OCCLUSION_CULLING = true;
+// Animation and physics run at this fixed rate, whatever the frame rate. Physics sweeps fast
+// bodies along their motion, so a low rate does not let them pass through walls.
+const float_t SIMULATION_STEP = 1.0f / 60;
+// Glowsticks are simulated as spheres, colliding with the level's own triangles.
+const float_t GLOWSTICK_RADIUS = .1f;
+const float_t GLOWSTICK_MASS = 10.0f;
+// How many glowsticks may be thrown before the oldest are reused.
+const size_t MAX_GLOWSTICKS = 256;
+// In the Game the camera walks as a capsule. Its eye height keeps the camera at y = 8.5 on
+// the level's floor, where the old fixed-height camera was.
+const float_t CAMERA_RADIUS = .5f;
+const float_t CAMERA_HEIGHT = 8.0f;
+const float_t CAMERA_EYE_HEIGHT = 7.5f;
+const float_t CAMERA_STEP_HEIGHT = 1.5f;
+const float_t CAMERA_GRAVITY = 30.0f;
+// Scene query layers: objects drawn when in view, and things the player can pick up.
+const uint32_t VISIBLE_LAYER = 1;
+const uint32_t PICKUP_LAYER = 2;
+// How far away the player can pick things up from.
+const float_t PICKUP_REACH = 12.0f;
+// The view's near and far clip distances.
+const float_t NEAR_PLANE = 0.1f;
+const float_t FAR_PLANE = 100.0f;
+// The edge length of the cubes the level is split into at import, so each piece can be culled,
+// sorted and occlusion tested on its own.
+const float_t LEVEL_CHUNK_SIZE = 16.0f;
 
 /**
  * @brief Defines a collection of objects that should be rendered with a specific shader program.
@@ -19,15 +68,54 @@ This application renders a textured mesh that was loaded with Assimp.
 
 struct Scene {
 	ShaderProgram defaultShader;
-	std::vector<Object3D> objects;
-	std::vector<Animator> animators;
-	//std::vector<ParallelAnimator> panimators;
+	// The same lights as defaultShader, for the lighting pass of deferred rendering.
+	ShaderProgram deferredShader;
+	ObjectStore objects;
+	// Handles to the scene's objects, in the order the scene added them.
+	std::vector<ObjectHandle> handles;
+	// Scheduled animations, which may overlap and nest.
+	Timeline timeline;
+	// Scheduled translations and rotations, played together from flat arrays.
+	AnimationSystem animations;
+	// The bounds of the scene's objects, for view culling and interaction.
+	SceneQuery query = SceneQuery();
+	// The rooms of an indoor scene and the doorways between them; empty outdoors.
+	PortalCells cells;
 };
 
-ShaderProgram phongLighting() {
+/**
+ * @brief Adds each of the scene's objects to its scene query, to be drawn only when in view.
+ */
+void addVisibleObjects(Scene& scene) {
+	for (auto& handle : scene.handles) {
+		scene.query.add(scene.objects, handle, VISIBLE_LAYER);
+	}
+}
+
+/**
+ * @brief Constructs a shader program that renders textured meshes in the Phong reflection model,
+ * compiled with only the lights and material features named in the given defines.
+ */
+ShaderProgram phongLighting(const ShaderDefines& defines = ShaderDefines()) {
+	ShaderProgram program;
+	try {
+		program = ShaderProgram::variant("shaders/light_perspective.vert", "shaders/multilights.frag", defines);
+	}
+	catch (std::runtime_error& e) {
+		std::cout << "ERROR: " << e.what() << std::endl;
+		exit(1);
+	}
+	return program;
+}
+
+/**
+ * @brief Constructs the deferred-shading counterpart of phongLighting: a fullscreen pass that
+ * lights the G-buffer with the lights named in the given defines.
+ */
+ShaderProgram deferredLighting(const ShaderDefines& defines = ShaderDefines()) {
 	ShaderProgram program;
 	try {
-		program.load("shaders/light_perspective.vert", "shaders/multilights.frag");
+		program = ShaderProgram::variant("shaders/fullscreen.vert", "shaders/deferred_lighting.frag", defines);
 	}
 	catch (std::runtime_error& e) {
 		std::cout << "ERROR: " << e.what() << std::endl;
@@ -60,6 +148,76 @@ Texture loadTexture(const std::filesystem::path& path, const std::string& sample
 	return Texture::loadImage(i, samplerName);
 }
 
+/**
+ * @brief A glowstick in the Game: the object drawn for it, and its physics body.
+ */
+struct Glowstick {
+	ObjectHandle object;
+	PhysicsWorld::BodyId body;
+};
+
+/**
+ * @brief Loads the Game level's collision geometry. The tree is baked next to the model on the
+ * first run, and loaded from there while the model is unchanged.
+ */
+TriangleBVH levelCollision() {
+	TriangleBVH collision;
+	try {
+		collision = assimpLoadCollision("models/Game/Level.obj", CollisionImportOptions{ {}, "models/Game/Level.bvh" });
+	}
+	catch (std::runtime_error& e) {
+		std::cout << "ERROR: " << e.what() << std::endl;
+		exit(1);
+	}
+	return collision;
+}
+
+/**
+ * @brief Loads the Game level's rooms and doorways, for drawing only the rooms in view.
+ */
+PortalCells levelCells() {
+	PortalCells cells;
+	try {
+		cells = PortalCells::load("models/Game/Level.cells");
+	}
+	catch (std::runtime_error& e) {
+		std::cout << "ERROR: " << e.what() << std::endl;
+		exit(1);
+	}
+	return cells;
+}
+
+/**
+ * @brief Loads the Intro's scripted camera flight.
+ */
+CameraPath introCameraPath() {
+	CameraPath path;
+	try {
+		path = CameraPath::load("models/Intro/Camera.path");
+	}
+	catch (std::runtime_error& e) {
+		std::cout << "ERROR: " << e.what() << std::endl;
+		exit(1);
+	}
+	return path;
+}
+
+/**
+ * @brief The Intro's road loop as keyframes: a road piece slides 36 units back, hops over the
+ * others to where it started, then slides 10 more.
+ */
+AnimationClip roadLoop(const glm::vec3& start) {
+	AnimationClip clip;
+	auto& position = clip.position();
+	position.addKey(0, start);
+	position.addKey(4, start + glm::vec3(-36, 0, 0));
+	position.addKey(4.01, start + glm::vec3(-36, 3, 0));
+	position.addKey(4.06, start + glm::vec3(0, 3, 0));
+	position.addKey(4.07, start);
+	position.addKey(8.07, start + glm::vec3(-10, 0, 0));
+	return clip;
+}
+
 Scene Intro() {
 	auto skybox = assimpLoad("models/Sky/Skybox.obj", true);
 	auto car = assimpLoad("models/Intro/Car.obj", true);
@@ -143,146 +301,129 @@ Scene Intro() {
 	road2.setPosition(glm::vec3(36, 0, 0));
 
 
-	std::vector<Object3D> objects;
-	objects.push_back(std::move(skybox));//0
-	objects.push_back(std::move(car));//1
-	objects.push_back(std::move(road));//2
-	objects.push_back(std::move(road1));//3
-	objects.push_back(std::move(road2));//4
-	objects.push_back(std::move(body));//5
-	objects.push_back(std::move(carDoor));
-	objects.push_back(std::move(carNW));
-	objects.push_back(std::move(badCar));
-	objects.push_back(std::move(swingB));
-
-
-	Animator ArmMoveR;
-	ArmMoveR.addAnimation(std::make_unique<PauseAnimation>(objects[5].getChild(4), 4));
-	ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4), .5, glm::vec3(0, 0, 1.5)),true);
-	ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4).getChild(1), .5, glm::vec3(0, 0, .5)),true);
-	for (int i = 0; i < 5; i++) {
-		ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4), .5, glm::vec3(0, 0, -1)));
-		ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4), .5, glm::vec3(0, 0, 1)));
-		i++;
+	ObjectStore objects;
+	std::vector<ObjectHandle> handles;
+	handles.push_back(objects.insert(std::move(skybox)));//0
+	handles.push_back(objects.insert(std::move(car)));//1
+	handles.push_back(objects.insert(std::move(road)));//2
+	handles.push_back(objects.insert(std::move(road1)));//3
+	handles.push_back(objects.insert(std::move(road2)));//4
+	handles.push_back(objects.insert(std::move(body)));//5
+	handles.push_back(objects.insert(std::move(carDoor)));
+	handles.push_back(objects.insert(std::move(carNW)));
+	handles.push_back(objects.insert(std::move(badCar)));
+	handles.push_back(objects.insert(std::move(swingB)));
+
+
+	// The Intro's choreography. Arms and legs move their upper and lower halves together.
+	ObjectRef armR(handles[5], { 4 });
+	ObjectRef foreArmR(handles[5], { 4, 1 });
+	ObjectRef armL(handles[5], { 5 });
+	ObjectRef foreArmL(handles[5], { 5, 1 });
+	ObjectRef legL(handles[5], { 3 });
+	ObjectRef shinL(handles[5], { 3, 1 });
+
+	auto waveR = TimelineNode::sequence();
+	auto waveL = TimelineNode::sequence();
+	for (int i = 0; i < 3; i++) {
+		waveR.add(TimelineNode::clip<RotationAnimation>(armR, .5, glm::vec3(0, 0, -1)));
+		waveR.add(TimelineNode::clip<RotationAnimation>(armR, .5, glm::vec3(0, 0, 1)));
+		waveL.add(TimelineNode::clip<RotationAnimation>(armL, .5, glm::vec3(0, 0, 1)));
+		waveL.add(TimelineNode::clip<RotationAnimation>(armL, .5, glm::vec3(0, 0, -1)));
 	}
-	ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4), .5, glm::vec3(0, 0, -2)));
-	ArmMoveR.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(4).getChild(1), .5, glm::vec3(0, 0, -1.5)));
-	
-	Animator ArmMoveL;
-	ArmMoveL.addAnimation(std::make_unique<PauseAnimation>(objects[5].getChild(5), 4));
-	ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5), .5, glm::vec3(0, 0, -1.5)), true);
-	ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5).getChild(1), .5, glm::vec3(0, 0, -.5)), true);
-	for (int i = 0; i < 5; i++) {
-		ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5), .5, glm::vec3(0, 0, 1)));
-		ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5), .5, glm::vec3(0, 0, -1)));
-		i++;
+
+	Timeline timeline;
+	timeline.add(TimelineNode::sequence(//right arm
+		TimelineNode::delay(4),
+		TimelineNode::parallel(
+			TimelineNode::clip<RotationAnimation>(armR, .5, glm::vec3(0, 0, 1.5)),
+			TimelineNode::clip<RotationAnimation>(foreArmR, .5, glm::vec3(0, 0, .5))),
+		TimelineNode::delay(.5),
+		std::move(waveR),
+		TimelineNode::clip<RotationAnimation>(armR, .5, glm::vec3(0, 0, -2)),
+		TimelineNode::clip<RotationAnimation>(foreArmR, .5, glm::vec3(0, 0, -1.5))));
+	timeline.add(TimelineNode::sequence(//left arm
+		TimelineNode::delay(4),
+		TimelineNode::parallel(
+			TimelineNode::clip<RotationAnimation>(armL, .5, glm::vec3(0, 0, -1.5)),
+			TimelineNode::clip<RotationAnimation>(foreArmL, .5, glm::vec3(0, 0, -.5))),
+		TimelineNode::delay(.5),
+		std::move(waveL),
+		TimelineNode::delay(1),
+		TimelineNode::clip<RotationAnimation>(armL, .5, glm::vec3(0, 0, .7)),
+		TimelineNode::clip<RotationAnimation>(foreArmL, .5, glm::vec3(0, 0, 1.2))));
+	timeline.add(TimelineNode::parallel(//left leg
+		TimelineNode::clip<RotationAnimation>(legL, 1, glm::vec3(.5, .25, 0)),
+		TimelineNode::clip<RotationAnimation>(shinL, 1, glm::vec3(-.25, 0, 0))), 8);
+
+	for (size_t road = 2; road <= 4; road++) {
+		timeline.add(TimelineNode::clip<ClipAnimation>(handles[road], roadLoop(objects[handles[road]].getPosition())));
 	}
-	ArmMoveL.addAnimation(std::make_unique<PauseAnimation>(objects[5].getChild(5), 1));
-	ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5), .5, glm::vec3(0, 0, .7)));
-	ArmMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(5).getChild(1), .5, glm::vec3(0, 0, 1.2)));
-
-	Animator LegMoveL;
-	LegMoveL.addAnimation(std::make_unique<PauseAnimation>(objects[5].getChild(3), 8));
-	LegMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(3), 1, glm::vec3(.5, .25, 0)), true);
-	LegMoveL.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(3).getChild(1), 1, glm::vec3(-.25, 0, 0)), true);
-	
-	Animator Body;
-	Body.addAnimation(std::make_unique<TranslationAnimation>(objects[5], 4, glm::vec3(-36, 0, 0)));
-	Body.addAnimation(std::make_unique<TranslationAnimation>(objects[5], 4, glm::vec3(-10, 0, 0)));
-	Body.addAnimation(std::make_unique<RotationAnimation>(objects[5], 2, glm::vec3(.1, 1, .1)));
-
-	Animator bCar;
-	bCar.addAnimation(std::make_unique<TranslationAnimation>(objects[8], 4, glm::vec3(-36, 0, 0)));
-	bCar.addAnimation(std::make_unique<TranslationAnimation>(objects[8], 4, glm::vec3(-10, 0, 0)));
-	
 
-	Animator Head;
-	Head.addAnimation(std::make_unique<PauseAnimation>(objects[5].getChild(1), 8));
-	Head.addAnimation(std::make_unique<RotationAnimation>(objects[5].getChild(1), 2, glm::vec3(0, .5, 0)));
-
-	Animator roadmove;
-	roadmove.addAnimation(std::make_unique<TranslationAnimation>(objects[2], 4, glm::vec3(-36, 0, 0)));
-	roadmove.addAnimation(std::make_unique<TranslationAnimation>(objects[2], .01, glm::vec3(0, 3, 0)));
-	roadmove.addAnimation(std::make_unique<TranslationAnimation>(objects[2], .05, glm::vec3(36, 0, 0)));
-	roadmove.addAnimation(std::make_unique<TranslationAnimation>(objects[2], .01, glm::vec3(0, -3, 0)));
-	roadmove.addAnimation(std::make_unique<TranslationAnimation>(objects[2], 4, glm::vec3(-10, 0, 0)));
-	Animator roadmove1;
-	roadmove1.addAnimation(std::make_unique<TranslationAnimation>(objects[3], 4, glm::vec3(-36, 0, 0)));
-	roadmove1.addAnimation(std::make_unique<TranslationAnimation>(objects[3], .01, glm::vec3(0, 3, 0)));
-	roadmove1.addAnimation(std::make_unique<TranslationAnimation>(objects[3], .05, glm::vec3(36, 0, 0)));
-	roadmove1.addAnimation(std::make_unique<TranslationAnimation>(objects[3], .01, glm::vec3(0, -3, 0)));
-	roadmove1.addAnimation(std::make_unique<TranslationAnimation>(objects[3], 4, glm::vec3(-10, 0, 0)));
-	Animator roadmove2;
-	roadmove2.addAnimation(std::make_unique<TranslationAnimation>(objects[4], 4, glm::vec3(-36, 0, 0)));
-	roadmove2.addAnimation(std::make_unique<TranslationAnimation>(objects[4], .01, glm::vec3(0, 3, 0)));
-	roadmove2.addAnimation(std::make_unique<TranslationAnimation>(objects[4], .05, glm::vec3(36, 0, 0)));
-	roadmove2.addAnimation(std::make_unique<TranslationAnimation>(objects[4], .01, glm::vec3(0, -3, 0)));
-	roadmove2.addAnimation(std::make_unique<TranslationAnimation>(objects[4], 4, glm::vec3(-10, 0, 0)));
-
-	Animator carSwap;
-	carSwap.addAnimation(std::make_unique<PauseAnimation>(objects[1], 3));
-	carSwap.addAnimation(std::make_unique<TranslationAnimation>(objects[1], .1,glm::vec3(0,-2,0)));
-
-	Animator carDoorMove;
-	carDoorMove.addAnimation(std::make_unique<PauseAnimation>(objects[6], 12));
-	carDoorMove.addAnimation(std::make_unique<RotationAnimation>(objects[6], 1, glm::vec3(0, -.5, 0)));
-
-	Animator batSwing;
-	batSwing.addAnimation(std::make_unique<PauseAnimation>(objects[9], 24.2));
-	batSwing.addAnimation(std::make_unique<TranslationAnimation>(objects[9], .1 ,glm::vec3(0,-10,0)));
-	batSwing.addAnimation(std::make_unique<PauseAnimation>(objects[9], .1));
-	batSwing.addAnimation(std::make_unique<RotationAnimation>(objects[9], .5,glm::vec3(0,glm::radians(90.0f), 0)));
-	
+	// Each sequence starts its next step at the time the previous one returns; pauses are gaps.
+	AnimationSystem animations;
+	float_t t = animations.addTranslation(handles[5], 0, 4, glm::vec3(-36, 0, 0));//Body
+	t = animations.addTranslation(handles[5], t, 4, glm::vec3(-10, 0, 0));
+	animations.addRotation(handles[5], t, 2, glm::vec3(.1, 1, .1));
+
+	t = animations.addTranslation(handles[8], 0, 4, glm::vec3(-36, 0, 0));//bad car
+	animations.addTranslation(handles[8], t, 4, glm::vec3(-10, 0, 0));
+
+	animations.addRotation(ObjectRef(handles[5], { 1 }), 8, 2, glm::vec3(0, .5, 0));//Head
 
-	std::vector<Animator> animators;
-	animators.push_back(std::move(Head));
-	animators.push_back(std::move(Body));
-	animators.push_back(std::move(carSwap));
-	animators.push_back(std::move(LegMoveL));
-	animators.push_back(std::move(ArmMoveR));
-	animators.push_back(std::move(ArmMoveL));
-	animators.push_back(std::move(roadmove));
-	animators.push_back(std::move(roadmove1));
-	animators.push_back(std::move(roadmove2));
-	animators.push_back(std::move(carDoorMove));
-	animators.push_back(std::move(bCar));
-	animators.push_back(std::move(batSwing));
+	animations.addTranslation(handles[1], 3, .1, glm::vec3(0, -2, 0));//car swap
 
+	animations.addRotation(handles[6], 12, 1, glm::vec3(0, -.5, 0));//car door
+
+	t = animations.addTranslation(handles[9], 24.2, .1, glm::vec3(0, -10, 0));//bat swing
+	animations.addRotation(handles[9], t + .1, .5, glm::vec3(0, glm::radians(90.0f), 0));
+
+	// The Intro is lit by the moon and the car's two headlights.
+	ShaderDefines lights = { {"NR_DIR_LIGHTS", "1"}, {"NR_POINT_LIGHTS", "0"}, {"NR_SPOT_LIGHTS", "2"} };
 	return Scene{
-		phongLighting(),
+		phongLighting(lights),
+		deferredLighting(lights),
 		std::move(objects),
-		std::move(animators),
+		std::move(handles),
+		std::move(timeline),
+		std::move(animations),
 	};
 }
 
 Scene Game() {
-	auto level = assimpLoad("models/Game/Level.obj", true);
+	auto level = assimpLoad("models/Game/Level.obj", true, false, ChunkImportOptions{ LEVEL_CHUNK_SIZE });
 	auto cap = assimpLoad("models/Game/cap.obj", true);
 	auto glowstick = assimpLoad("models/game/GlowStick.obj", true);
-	auto carrot0 = assimpLoad("models/game/Carrot0.obj", true);
-	auto carrot1 = assimpLoad("models/game/Carrot1.obj", true);
-	auto carrot2 = assimpLoad("models/game/Carrot2.obj", true);
-	auto carrot3 = assimpLoad("models/game/Carrot3.obj", true);
+	auto carrot0 = assimpLoad("models/game/Carrot0.obj", true, true);
+	auto carrot1 = assimpLoad("models/game/Carrot1.obj", true, true);
+	auto carrot2 = assimpLoad("models/game/Carrot2.obj", true, true);
+	auto carrot3 = assimpLoad("models/game/Carrot3.obj", true, true);
 	auto carrotc = assimpLoad("models/game/CarrotC.obj", true);
-	glowstick.setMass(10.0f);
 	glowstick.setScale(glm::vec3(.1));
 	glowstick.setPosition(glm::vec3(0, 5, 0));
 
 	cap.setPosition(glm::vec3(0, .91351, -5.6626));
 	//cap.rotate(glm::vec3(glm::radians(-90.0f), 0, 0));
-	std::vector<Object3D> objects;
-	objects.push_back(std::move(level));
-	objects.push_back(std::move(glowstick));
-	objects.push_back(std::move(cap));
-	objects.push_back(std::move(carrot0));
-	objects.push_back(std::move(carrot1));
-	objects.push_back(std::move(carrot2));
-	objects.push_back(std::move(carrot3));
-	objects.push_back(std::move(carrotc));
-
+	ObjectStore objects;
+	std::vector<ObjectHandle> handles;
+	handles.push_back(objects.insert(std::move(level)));
+	handles.push_back(objects.insert(std::move(glowstick)));
+	handles.push_back(objects.insert(std::move(cap)));
+	handles.push_back(objects.insert(std::move(carrot0)));
+	handles.push_back(objects.insert(std::move(carrot1)));
+	handles.push_back(objects.insert(std::move(carrot2)));
+	handles.push_back(objects.insert(std::move(carrot3)));
+	handles.push_back(objects.insert(std::move(carrotc)));
+
+	// The Game is lit by the moon and any number of glowsticks, which are binned into clusters
+	// so each fragment only shades the glowsticks in range of it. It has no spotlights.
+	ShaderDefines lights = { {"NR_DIR_LIGHTS", "1"}, {"NR_POINT_LIGHTS", "0"}, {"NR_SPOT_LIGHTS", "0"},
+		{"CLUSTERED_LIGHTING", "1"} };
 	return Scene{
-		phongLighting(),
+		phongLighting(lights),
+		deferredLighting(lights),
 		std::move(objects),
+		std::move(handles),
 	};
 }
 
@@ -308,575 +449,351 @@ int main() {
 	auto scene = Intro();
 	bool boolscene = true;
 	auto scene1 = Game();
+	scene1.cells = levelCells();
 	bool boolscene1 = false;
-
-	auto& glow0 = scene1.objects[1];
+	addVisibleObjects(scene);
+	addVisibleObjects(scene1);
+
+	// The Game's physics: the level, and a body for each glowstick. The Game starts with one
+	// glowstick, which the others are copied from.
+	PhysicsWorld physics;
+	physics.addStaticMesh(levelCollision());
+	std::vector<Glowstick> glowsticks;
+	glowsticks.push_back(Glowstick{ scene1.handles[1],
+		physics.addSphere(scene1.objects[scene1.handles[1]].getPosition(), GLOWSTICK_RADIUS, GLOWSTICK_MASS, .7f, .3f) });
+	size_t nextRethrow = 0;
+	bool throwHeld = false;
+	CharacterController walker(physics, CAMERA_RADIUS, CAMERA_HEIGHT, CAMERA_EYE_HEIGHT, CAMERA_STEP_HEIGHT,
+		CAMERA_GRAVITY);
+	// Point and spot lights for the Game, re-binned against the camera every frame.
+	ClusteredLights gameLights;
+	// The Game's carrots, found by looking at them. Each sets its flag when picked up.
+	bool* carrotTaken[] = { &car0, &car1, &car2, &car3 };
+	for (size_t i = 0; i < 4; i++) {
+		scene1.query.add(scene1.objects, scene1.handles[3 + i], VISIBLE_LAYER | PICKUP_LAYER);
+	}
 
 	//camera stuff
 	Camera camera;
+	CameraPath introCamera = introCameraPath();
 	double fov = 45.0;
-	auto perspective = glm::perspective(glm::radians(fov), static_cast<double>(window.getSize().x) / window.getSize().y, 0.1, 100.0);
-	camera.Pos = glm::vec3(4, 5, 0);
-	camera.Front = glm::vec3(-.6, -.6, .3);
+	introCamera.apply(camera, 0);
 	//
 	//camera.Pos = (glm::vec3(95, 1, 45));
 	//
-	ShaderProgram& mainShader = scene.defaultShader;
+	Renderer renderer(RENDER_MODE);
+	renderer.setDepthPrepass(DEPTH_PREPASS);
+	renderer.setOcclusionCulling(OCCLUSION_CULLING);
+	auto lightingShader = [](Scene& s) {
+		return RENDER_MODE == Renderer::Mode::Deferred ? &s.deferredShader : &s.defaultShader;
+	};
+	// Each scene has its own shader variant; this points at the one for the active scene.
+	ShaderProgram* mainShader = lightingShader(scene);
 
 	glEnable(GL_LIGHT1 + 1);
-	mainShader.activate();
+	mainShader->activate();
 
-	mainShader.setUniform("pointLight.position", glm::vec3(0, 0, 0));
-	mainShader.setUniform("pointLight.ambient", glm::vec3(0));
-	mainShader.setUniform("pointLight.diffuse", glm::vec3(0));
-	mainShader.setUniform("pointLight.specular", glm::vec3(0));
-	mainShader.setUniform("pointLight.constant", 1.0f);
-	mainShader.setUniform("pointLight.linear", 0.09f);
-	mainShader.setUniform("pointLight.quadratic", 0.032f);
+	// Animation and physics advance in fixed steps; rendering blends the last two steps.
+	FixedTimestep simulation(SIMULATION_STEP);
 
 	// Ready, set, go!
-	for (auto& animator : scene.animators) {
-		animator.start();
-	}
-	bool running = true;
-	sf::Clock c;
-	auto last = c.getElapsedTime();
-	while (running) {
-		sf::Event ev;
-		while (window.pollEvent(ev)) {
-			if (ev.type == sf::Event::Closed) {
-				running = false;
-			}
-		}
-		window.clear();
-		glm::mat4 view = camera.GetViewMatrix();
-		perspective = glm::perspective(glm::radians(fov), static_cast<double>(window.getSize().x) / window.getSize().y, 0.1, 100.0);
-
-		mainShader.setUniform("viewPos", camera.Pos);
-		mainShader.setUniform("view", view);
-		mainShader.setUniform("projection", perspective);
-		mainShader.setUniform("material", glm::vec4(.1, .5, 1, 32));
-
-		//std::cout << "X: " << camera.Front.x << "Y: " << camera.Front.y << "Z: " << camera.Front.z << std::endl;
-		std::cout << "PX: " << camera.Pos.x << "PY: " << camera.Pos.y << "PZ: " << camera.Pos.z << std::endl;
-		//std::cout << "Y: " << camera.Yaw << "P:" << camera.Pitch << std::endl;
-		auto now = c.getElapsedTime();
-		auto diff = now - last;
-		auto diffSeconds = diff.asSeconds();
-		last = now;
-		camera.Movespeed = 10.0f * diffSeconds;
-
-		// camera controls:
-		if (CameraEnabled) {
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Equal)) {
-				if (!FPS)
-					FPS = true;
-				else
-					FPS = false;
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Space)) {
-				camera.ProcessMovement(SPACE, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::LControl)) {
-				camera.ProcessMovement(CTRL, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::W)) {
-				camera.ProcessMovement(FORWARD, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::S)) {
-				camera.ProcessMovement(BACKWARD, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::D)) {
-				camera.ProcessMovement(RIGHT, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::A)) {
-				camera.ProcessMovement(LEFT, FPS);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Up)) {
-				camera.ProcessAngle(CUP);
-
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Down)) {
-				camera.ProcessAngle(CDOWN);
-
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Left)) {
-				camera.ProcessAngle(CLEFT);
+	scene.timeline.start();
+	scene.animations.start();
+	// The simulation thread: input, animation, physics and scene logic. It never calls OpenGL;
+	// each frame ends by publishing a render snapshot, which the render thread below draws while
+	// the next frame is simulated.
+	std::atomic<bool> running(true);
+	FramePipeline pipeline;
+	// Workers for the simulation's per-object stages.
+	JobSystem jobs;
+	// The window's aspect ratio, for the simulation thread's projection.
+	std::atomic<float_t> viewAspect(static_cast<float_t>(width) / height);
+	std::thread simulationThread([&]() {
+		std::vector<ObjectHandle> visibleHandles;
+		std::vector<const Object3D*> visibleObjects;
+		VisibleCells visibleCells;
+		sf::Clock c;
+		auto last = c.getElapsedTime();
+		while (running) {
+			RenderSnapshot& snapshot = pipeline.building();
+			//std::cout << "X: " << camera.Front.x << "Y: " << camera.Front.y << "Z: " << camera.Front.z << std::endl;
+			std::cout << "PX: " << camera.Pos.x << "PY: " << camera.Pos.y << "PZ: " << camera.Pos.z << std::endl;
+			//std::cout << "Y: " << camera.Yaw << "P:" << camera.Pitch << std::endl;
+			auto now = c.getElapsedTime();
+			auto diff = now - last;
+			auto diffSeconds = diff.asSeconds();
+			last = now;
+			simulation.advance(diffSeconds);
+			camera.Movespeed = 10.0f * diffSeconds;
+
+			// camera controls: in the Game's FPS mode the camera walks through the level, otherwise
+			// it flies freely.
+			bool walking = FPS && boolscene1;
+			glm::vec3 walk(0);
+			auto moveCamera = [&](Camera_Movement direction) {
+				if (walking) {
+					walk += camera.MovementOffset(direction, FPS);
+				}
+				else {
+					camera.ProcessMovement(direction, FPS);
+				}
+			};
+			if (CameraEnabled) {
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Equal)) {
+					if (!FPS)
+						FPS = true;
+					else
+						FPS = false;
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Space)) {
+					moveCamera(SPACE);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::LControl)) {
+					moveCamera(CTRL);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::W)) {
+					moveCamera(FORWARD);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::S)) {
+					moveCamera(BACKWARD);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::D)) {
+					moveCamera(RIGHT);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::A)) {
+					moveCamera(LEFT);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Up)) {
+					camera.ProcessAngle(CUP);
 
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Right)) {
-				camera.ProcessAngle(CRIGHT);
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Down)) {
+					camera.ProcessAngle(CDOWN);
 
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Q)) {
-				fov = 20.0;
-			}
-			else {
-				fov = 45.0;
-			}
-		}
-		if (boolscene) {
-			mainShader.setUniform("dirLight.direction", glm::vec3(0.0f, -6.0f, 0.0f));
-			mainShader.setUniform("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-			mainShader.setUniform("dirLight.diffuse", glm::vec3(0.04f, 0.04f, 0.04f));
-			mainShader.setUniform("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
-			mainShader.setUniform("spotLight[0].position", glm::vec3(1.5, .45, .7));
-			mainShader.setUniform("spotLight[0].direction", glm::vec3(1, 0, 0));
-			mainShader.setUniform("spotLight[0].ambient", glm::vec3(0, 0, 0));
-			mainShader.setUniform("spotLight[0].diffuse", glm::vec3(1, 1, 1));
-			mainShader.setUniform("spotLight[0].specular", glm::vec3(1, 1, 1));
-			mainShader.setUniform("spotLight[0].constant", 1.0f);
-			mainShader.setUniform("spotLight[0].linear", 0.09f);
-			mainShader.setUniform("spotLight[0].quadratic", 0.032f);
-			mainShader.setUniform("spotLight[0].cutOff", glm::cos(glm::radians(12.5f)));
-			mainShader.setUniform("spotLight[0].outerCutOff", glm::cos(glm::radians(15.0f)));
-			mainShader.setUniform("spotLight[1].position", glm::vec3(1.5, .45, 1.7));
-			mainShader.setUniform("spotLight[1].direction", camera.Front);
-			mainShader.setUniform("spotLight[1].ambient", glm::vec3(0, 0, 0));
-			mainShader.setUniform("spotLight[1].diffuse", glm::vec3(1, 1, 1));
-			mainShader.setUniform("spotLight[1].specular", glm::vec3(1, 1, 1));
-			mainShader.setUniform("spotLight[1].constant", 1.0f);
-			mainShader.setUniform("spotLight[1].linear", 0.09f);
-			mainShader.setUniform("spotLight[1].quadratic", 0.032f);
-			mainShader.setUniform("spotLight[1].cutOff", glm::cos(glm::radians(12.5f)));
-			mainShader.setUniform("spotLight[1].outerCutOff", glm::cos(glm::radians(15.0f)));
-
-			if (c.getElapsedTime().asSeconds() > 1.5 && c.getElapsedTime().asSeconds() < 9) {
-				if (camera.Pos.x > 0)
-					camera.Pos.x -= 1.5 * diffSeconds;
-				if (camera.Pos.y > 1)
-					camera.Pos.y -= 1 * diffSeconds;
-				if (camera.Pos.z < 1)
-					camera.Pos.z += 1 * diffSeconds;
-				if (camera.Front.x < 2)
-					camera.Front.x += .5 * diffSeconds;
-			}
+				}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Left)) {
+					camera.ProcessAngle(CLEFT);
 
-			if (c.getElapsedTime().asSeconds() > 5 && c.getElapsedTime().asSeconds() < 11) {
-				if (camera.Front.y < 0 && camera.Front.z > 0) {
-					camera.Front.y = 0;
-					camera.Front.z = 0;
 				}
-			}
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Right)) {
+					camera.ProcessAngle(CRIGHT);
 
-			if (c.getElapsedTime().asSeconds() > 11 && c.getElapsedTime().asSeconds() < 13) {
-				if (camera.Front.z > 0)
-					camera.Front.x += 2 * diffSeconds;
-				camera.Front.z -= 2 * diffSeconds;
-			}
-			if (c.getElapsedTime().asSeconds() > 13 && c.getElapsedTime().asSeconds() < 16) {
-				if (camera.Pos.z > -.5)
-					camera.Pos.z -= 1 * diffSeconds;
-				if (camera.Pos.y < 1.5)
-					camera.Pos.y += .3 * diffSeconds;
-				if (camera.Front.z < 0)
-					camera.Front.z += 2 * diffSeconds;
-				if (camera.Front.x > 1)
-					camera.Front.x -= 2 * diffSeconds;
-			}
-			if (c.getElapsedTime().asSeconds() > 16 && c.getElapsedTime().asSeconds() < 18) {
-				if (camera.Front.x > .9) {
-					camera.Front.x -= 2 * diffSeconds;
 				}
-				if (camera.Front.z < .3)
-					camera.Front.z += 2 * diffSeconds;
-			}
-			if (c.getElapsedTime().asSeconds() > 18 && c.getElapsedTime().asSeconds() < 20) {
-				camera.Pos.x += 5.5 * diffSeconds;
-				camera.Pos.z += 1 * diffSeconds;
-			}
-			if (c.getElapsedTime().asSeconds() > 20 && c.getElapsedTime().asSeconds() < 21) {
-				camera.Pos.y -= .5 * diffSeconds;
-				camera.Front.y -= .5 * diffSeconds;
+				if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::Q)) {
+					fov = 20.0;
+				}
+				else {
+					fov = 45.0;
+				}
 			}
-			if (c.getElapsedTime().asSeconds() > 23 && c.getElapsedTime().asSeconds() < 25) {
-				camera.Front.x -= .5 * diffSeconds;
-				camera.Front.z -= .5 * diffSeconds;
-				camera.Front.y += .4 * diffSeconds;
+			if (walking) {
+				walker.move(camera, walk, diffSeconds);
 			}
-			if (c.getElapsedTime().asSeconds() > 25 && c.getElapsedTime().asSeconds() < 26) {
-				camera.Up.z -= 5 * diffSeconds;
-				camera.Pos.y -= .5 * diffSeconds;
-
-			}
-			if (c.getElapsedTime().asSeconds() > 26) {
-				boolscene = false;
-				boolscene1 = true;
-				CameraEnabled = true;
-				mainShader.setUniform("spotLight[0].ambient", glm::vec3(0, 0, 0));
-				mainShader.setUniform("spotLight[0].diffuse", glm::vec3(0, 0, 0));
-				mainShader.setUniform("spotLight[0].specular", glm::vec3(0, 0, 0));
-				mainShader.setUniform("spotLight[1].ambient", glm::vec3(0, 0, 0));
-				mainShader.setUniform("spotLight[1].diffuse", glm::vec3(0, 0, 0));
-				mainShader.setUniform("spotLight[1].specular", glm::vec3(0, 0, 0));
-				FPS = true;
+			if (boolscene) {
+				// The cutscene camera follows its path by the clock, independent of frame rate.
+				float_t introTime = c.getElapsedTime().asSeconds();
+				introCamera.apply(camera, introTime);
+				if (introTime > introCamera.duration()) {
+					boolscene = false;
+					boolscene1 = true;
+					CameraEnabled = true;
+					FPS = true;
 
-			}
+				}
 
-			for (auto& animator : scene.animators) {
-				animator.tick(diffSeconds);
+				auto& objects = scene.objects.values();
+				while (simulation.step()) {
+					jobs.parallelFor(objects.size(), 16, [&](size_t i) { objects[i].savePreviousTransform(); });
+					scene.timeline.tick(SIMULATION_STEP, scene.objects);
+					scene.animations.tick(SIMULATION_STEP, scene.objects);
+				}
+				// Each root's hierarchy is independent, so the roots interpolate in parallel.
+				float_t alpha = simulation.alpha();
+				jobs.parallelFor(objects.size(), 16, [&](size_t i) { objects[i].interpolateTransform(alpha); });
 			}
-		}
 
-		if (boolscene1) {
-			glow0.tick(diffSeconds);
-			auto& glowpos = glow0.getPosition();
-			glow0.addForce(glm::vec3(0, -9.8f * glow0.getMass(), 0));
-			mainShader.setUniform("pointLight.position", glowpos);
-			mainShader.setUniform("pointLight.ambient", glm::vec3(.05f));
-			mainShader.setUniform("pointLight.diffuse", glm::vec3(.8f));
-			mainShader.setUniform("pointLight.specular", glm::vec3(.1f, .5f, .1f));
-			mainShader.setUniform("pointLight.constant", 1.0f);
-			mainShader.setUniform("pointLight.linear", 0.09f);
-			mainShader.setUniform("pointLight.quadratic", 0.032f);
-			//std::cout << "x: " << glowpos.x << "Y: " << glowpos.z << "Z: " << glowpos.z << "vel : " << glow0.getVelocity().y << "M: " << glow0.getMass() << std::endl;
-			if (c.getElapsedTime().asSeconds() > 26 && c.getElapsedTime().asSeconds() < 26.1) {
-				camera.Pos = glm::vec3(0, 8.5, 18);
-				camera.Up = glm::vec3(0, 1, 0);
-				camera.Front = glm::vec3(0, 0, 0);
-				camera.Yaw = 270;
-				camera.Pitch = 0;
+			if (boolscene1) {
+				if (c.getElapsedTime().asSeconds() > 26 && c.getElapsedTime().asSeconds() < 26.1) {
+					camera.Pos = glm::vec3(0, 8.5, 18);
+					camera.Up = glm::vec3(0, 1, 0);
+					camera.Front = glm::vec3(0, 0, 0);
+					camera.Yaw = 270;
+					camera.Pitch = 0;
 
-			}
-			if (glowpos.y < 1) {
-				glow0.setPosition(glm::vec3(glowpos.x, 1,glowpos.z));
-				glow0.setVelocity(glm::vec3(1, -1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::E)) {
-				glow0.setOrientation(camera.Front);
-				glow0.setPosition(camera.Pos);
-				glow0.setVelocity(glm::vec3(camera.Front.x * 15, 10, camera.Front.z * 15));
-			}
-			
+				}
+				// Each press of E throws another glowstick from the camera. Once there are
+				// MAX_GLOWSTICKS, the oldest is thrown again instead.
+				bool throwPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::Scan::E);
+				if (throwPressed && !throwHeld) {
+					if (glowsticks.size() < MAX_GLOWSTICKS) {
+						Object3D copy = scene1.objects[glowsticks.front().object];
+						glowsticks.push_back(Glowstick{ scene1.objects.insert(std::move(copy)),
+							physics.addSphere(camera.Pos, GLOWSTICK_RADIUS, GLOWSTICK_MASS, .7f, .3f) });
+						scene1.query.add(scene1.objects, glowsticks.back().object, VISIBLE_LAYER);
+						nextRethrow = glowsticks.size() - 1;
+					}
+					Glowstick& thrown = glowsticks[nextRethrow];
+					nextRethrow = (nextRethrow + 1) % MAX_GLOWSTICKS;
+					auto& stick = scene1.objects[thrown.object];
+					stick.setOrientation(camera.Front);
+					stick.setPosition(camera.Pos);
+					stick.savePreviousTransform();
+					physics.setPosition(thrown.body, camera.Pos);
+					physics.setVelocity(thrown.body, glm::vec3(camera.Front.x * 15, 10, camera.Front.z * 15));
+				}
+				throwHeld = throwPressed;
+
+				// Physics runs in fixed steps, so falls and bounces are the same at any frame rate.
+				while (simulation.step()) {
+					for (auto& stick : glowsticks) {
+						scene1.objects[stick.object].savePreviousTransform();
+					}
+					physics.step(SIMULATION_STEP);
+					for (auto& stick : glowsticks) {
+						scene1.objects[stick.object].setPosition(physics.position(stick.body));
+					}
+				}
+				float_t alpha = simulation.alpha();
+				for (auto& stick : glowsticks) {
+					auto& object = scene1.objects[stick.object];
+					object.interpolateTransform(alpha);
+					// The light moves with the stick as drawn, not one step ahead of it.
+					snapshot.lights.push_back(PointLightData{ object.getInterpolatedPosition(alpha), glm::vec3(.05f),
+						glm::vec3(.8f), glm::vec3(.1f, .5f, .1f), 1.0f, 0.09f, 0.032f });
+				}
+				// Pick up the carrot the player is looking at, if it is within reach and no wall is
+				// nearer. The query's bounds are from the end of the last frame; carrots do not move.
+				float_t reach = PICKUP_REACH;
+				CastHit wall;
+				if (physics.raycastStatic(camera.Pos, camera.Front, reach, wall)) {
+					reach = wall.distance;
+				}
+				SceneHit looked;
+				if (scene1.query.raycast(scene1.objects, camera.Pos, camera.Front, reach, PICKUP_LAYER, true,
+					looked)) {
+					for (size_t i = 0; i < 4; i++) {
+						if (looked.object == scene1.handles[3 + i]) {
+							*carrotTaken[i] = true;
+							// Picked up: remove the carrot from the scene. The frame being drawn may still
+							// show it, so the snapshot keeps it alive until that frame is done.
+							scene1.objects.erase(looked.object, snapshot.retired);
+						}
+					}
+				}
+				//tele holes
+				if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 46 && camera.Pos.x < 56) {
+					camera.Pos = glm::vec3(0, 8.5, 18);
+				}
+				if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 59 && camera.Pos.x < 69) {
+					camera.Pos = glm::vec3(0, 8.5, 18);
+				}
+				if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 71 && camera.Pos.x < 80) {
 
-			//Big Room
-			if (glowpos.x < -19.9 && glowpos.x > -21 && glowpos.z < 11.9 && glowpos.z > -52.1) {
-				glow0.setPosition(glm::vec3(-19.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > -52.1 && glowpos.z < -51 && glowpos.x < -19.9 && glowpos.x > -60.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -52.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > -60.1 && glowpos.x < -59 && glowpos.z < 12.1 && glowpos.z > -52.1) {
-				glow0.setPosition(glm::vec3(-60.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > 11.9 && glowpos.z < 13 && glowpos.x < -59.9 && glowpos.x > -124.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 11.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < -123.9 && glowpos.x > -125 && glowpos.z < 11.9 && glowpos.z > -52.1) {
-				glow0.setPosition(glm::vec3(-123.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < -51.9 && glowpos.z > -53 && glowpos.x < -67.9 && glowpos.x > -124.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -51.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < -67.9 && glowpos.x > -69 && glowpos.z < -51.9 && glowpos.z > -60.1) {
-				glow0.setPosition(glm::vec3(-67.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < -59.9 && glowpos.z > -61 && glowpos.x < -11.9 && glowpos.x > -68.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -59.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > -12.1 && glowpos.x < -11 && glowpos.z < -19.9 && glowpos.z > -60.1) {
-				glow0.setPosition(glm::vec3(-12.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			//Portal
-			if (glowpos.z < -19.9 && glowpos.z > -21 && glowpos.x < 60.1 && glowpos.x > -12.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -19.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < 60.1 && glowpos.x > 59 && glowpos.z < -19.9 && glowpos.z > -44.1) {
-				glow0.setPosition(glm::vec3(60.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > -44.1 && glowpos.z < -43 && glowpos.x < 60.1 && glowpos.x > 43.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -44.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < 44.1 && glowpos.x > 43 && glowpos.z < -43.9 && glowpos.z > -84.1) {
-				glow0.setPosition(glm::vec3(44.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < -83.9 && glowpos.z > -85 && glowpos.x < 84.1 && glowpos.x > 43.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -83.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > 83.9 && glowpos.x < 85 && glowpos.z < -43.9 && glowpos.z > -84.1) {
-				glow0.setPosition(glm::vec3(83.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > -44.1 && glowpos.z < -43 && glowpos.x < 84.1 && glowpos.x > 68.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -44.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > 67.9 && glowpos.x < 69 && glowpos.z < -11.9 && glowpos.z > -44.1) {
-				glow0.setPosition(glm::vec3(67.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > -12.1 && glowpos.z < -11 && glowpos.x < 68.1 && glowpos.x > 19.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -12.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			//L Hall
-			if (glowpos.x > 19.9 && glowpos.x < 21 && glowpos.z < 52.1 && glowpos.z > -12.1) {
-				glow0.setPosition(glm::vec3(19.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < 52.1 && glowpos.z > 51 && glowpos.x < 52.1 && glowpos.x > 20.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 52.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > 51.9 && glowpos.x < 53 && glowpos.z < 60.1 && glowpos.z > 51.9) {
-				glow0.setPosition(glm::vec3(51.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > 59.9 && glowpos.z < 61 && glowpos.x < 52.1 && glowpos.x > 11.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 59.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < 12.1 && glowpos.x > 11 && glowpos.z < 60.1 && glowpos.z > 19.9) {
-				glow0.setPosition(glm::vec3(12.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1) * glow0.getVelocity() * .7f);
-			}
-			//Corner
-			if (glowpos.z > 19.9 && glowpos.z < 21 && glowpos.x < 12.1 && glowpos.x >-33.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 19.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > -34.1 && glowpos.x < -33 && glowpos.z < 52.1 && glowpos.z > 20.1) {
-				glow0.setPosition(glm::vec3(-34.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < 52.1 && glowpos.z > 51 && glowpos.x < -17.9 && glowpos.x >-34.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 52.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < -17.9 && glowpos.x > -19 && glowpos.z < 52.1 && glowpos.z >35.9) {
-				glow0.setPosition(glm::vec3(-17.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > 35.9 && glowpos.z < 37 && glowpos.x < -17.9 && glowpos.x >-32.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 35.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < -31.9 && glowpos.x > -33 && glowpos.z < 36.1 && glowpos.z >29.9) {
-				glow0.setPosition(glm::vec3(-31.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < 29.9 && glowpos.z > 29 && glowpos.x < -9.9 && glowpos.x > -32.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 29.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > -10.1 && glowpos.x < -9 && glowpos.z < 60.1 && glowpos.z >28.9) {
-				glow0.setPosition(glm::vec3(-10.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > 59.9 && glowpos.z < 61 && glowpos.x < -9.9 && glowpos.x >-42.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 59.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < -41.9 && glowpos.x > -43 && glowpos.z < 60.1 && glowpos.z >-28.1) {
-				glow0.setPosition(glm::vec3(-41.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < -27.9 && glowpos.z > -29 && glowpos.x < -33.9 && glowpos.x >-42.1) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, -27.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x > -34.1 && glowpos.x < -33 && glowpos.z < 12.1 && glowpos.z >-27.9) {
-				glow0.setPosition(glm::vec3(-34.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < 12.1 && glowpos.z > 11 && glowpos.x < -19.9 && glowpos.x >-34.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 12.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			//Hole
-			if (glowpos.x > 109.9 && glowpos.x < 111 && glowpos.z < 60.1 && glowpos.z >27.9) {
-				glow0.setPosition(glm::vec3(109.9, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z > 59.9 && glowpos.z < 61 && glowpos.x < 110.1 && glowpos.x >79.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 59.9));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (glowpos.x < 80.1 && glowpos.x > 79 && glowpos.z < 60.1 && glowpos.z >27.9) {
-				glow0.setPosition(glm::vec3(80.1, glowpos.y, glowpos.z));
-				glow0.setVelocity(glm::vec3(-1, 1, 1)* glow0.getVelocity() * .7f);
-			}
-			if (glowpos.z < 28.1 && glowpos.z > 27 && glowpos.x < 110.1 && camera.Pos.x >79.9) {
-				glow0.setPosition(glm::vec3(glowpos.x, glowpos.y, 28.1));
-				glow0.setVelocity(glm::vec3(1, 1, -1) * glow0.getVelocity() * .7f);
-			}
-			if (camera.Pos.z > 32 && camera.Pos.z < 40 && camera.Pos.x >90 && camera.Pos.x < 98) {
-				car0 = true;
-				scene1.objects[3].setPosition(glm::vec3(0, -6, 0));
-			}
-			//tele holes
-			if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 46 && camera.Pos.x < 56) {
-				camera.Pos = glm::vec3(0, 8.5, 18);
-			}
-			if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 59 && camera.Pos.x < 69) {
-				camera.Pos = glm::vec3(0, 8.5, 18);
+				}
 			}
-			if (camera.Pos.z > -78 && camera.Pos.z < -68 && camera.Pos.x > 71 && camera.Pos.x < 80) {
 
+			// Record the frame for the render thread. Only the objects in view are drawn; the
+			// scene query refits the bounds of whatever moved this frame and finds them, and
+			// indoors, only the meshes in rooms seen through the doorways are kept.
+			Scene& shown = boolscene ? scene : scene1;
+			snapshot.lighting = lightingShader(shown);
+			snapshot.view = camera.GetViewMatrix();
+			snapshot.projection = glm::perspective(glm::radians(static_cast<float_t>(fov)), viewAspect.load(),
+				NEAR_PLANE, FAR_PLANE);
+			snapshot.viewPos = camera.Pos;
+			snapshot.viewFront = camera.Front;
+			shown.query.update(shown.objects);
+			visibleHandles.clear();
+			Frustum frustum = Frustum::fromMatrix(snapshot.projection * snapshot.view);
+			shown.query.overlapFrustum(frustum, VISIBLE_LAYER, visibleHandles);
+			shown.cells.findVisible(camera.Pos, frustum, visibleCells);
+			visibleObjects.clear();
+			for (auto& handle : visibleHandles) {
+				visibleObjects.push_back(shown.objects.get(handle));
+			}
+			snapshot.addObjects(visibleObjects, jobs, &visibleCells);
+			snapshot.sortFrontToBack();
+			if (!pipeline.publish()) {
+				break;
 			}
+		}
+	});
 
-
-			//Big Room
-			if (camera.Pos.x < -19.9 && camera.Pos.x > -21 && camera.Pos.z < 11.9 && camera.Pos.z > -52.1) {
-				camera.Pos.x = -19.9;
-			}
-			if (camera.Pos.z > -52.1 && camera.Pos.z < -51 && camera.Pos.x < -19.9 && camera.Pos.x > -60.1) {
-				camera.Pos.z = -52.1;
-			}
-			if (camera.Pos.x > -60.1 && camera.Pos.x < -59 && camera.Pos.z < 12.1 && camera.Pos.z > -52.1) {
-				camera.Pos.x = -60.1;//1
-			}
-			if (camera.Pos.z > 11.9 && camera.Pos.z < 13 && camera.Pos.x < -59.9 && camera.Pos.x > -124.1) {
-				camera.Pos.z = 11.9;//2
-			}
-			if (camera.Pos.x < -123.9 && camera.Pos.x > -125 && camera.Pos.z < 11.9 && camera.Pos.z > -52.1) {
-				camera.Pos.x = -123.9;//3
-			}
-			if (camera.Pos.z < -51.9 && camera.Pos.z > -53 && camera.Pos.x < -67.9 && camera.Pos.x > -124.1) {
-				camera.Pos.z = -51.9;//4
-			}
-			if (camera.Pos.x < -67.9 && camera.Pos.x > -69 && camera.Pos.z < -51.9 && camera.Pos.z > -60.1) {
-				camera.Pos.x = -67.9;
-			}
-			if (camera.Pos.z < -59.9 && camera.Pos.z > -61 && camera.Pos.x < -11.9 && camera.Pos.x > -68.1) {
-				camera.Pos.z = -59.9;
-			}
-			if (camera.Pos.x > -12.1 && camera.Pos.x < -11 && camera.Pos.z < -19.9 && camera.Pos.z > -60.1) {
-				camera.Pos.x = -12.1;
-			}
-			//Portal
-			if (camera.Pos.z < -19.9 && camera.Pos.z > -21 && camera.Pos.x < 60.1 && camera.Pos.x > -12.1) {
-				camera.Pos.z = -19.9;
-			}
-			if (camera.Pos.x < 60.1 && camera.Pos.x > 59 && camera.Pos.z < -19.9 && camera.Pos.z > -44.1) {
-				camera.Pos.x = 60.1;
-			}
-			if (camera.Pos.z > -44.1 && camera.Pos.z < -43 && camera.Pos.x < 60.1 && camera.Pos.x > 43.9) {
-				camera.Pos.z = -44.1;
-			}
-			if (camera.Pos.x < 44.1 && camera.Pos.x > 43 && camera.Pos.z < -43.9 && camera.Pos.z > -84.1) {
-				camera.Pos.x = 44.1;
-			}
-			if (camera.Pos.z < -83.9 && camera.Pos.z > -85 && camera.Pos.x < 84.1 && camera.Pos.x > 43.9) {
-				camera.Pos.z = -83.9;
-			}
-			if (camera.Pos.x > 83.9 && camera.Pos.x < 85 && camera.Pos.z < -43.9 && camera.Pos.z > -84.1) {
-				camera.Pos.x = 83.9;
-			}
-			if (camera.Pos.z > -44.1 && camera.Pos.z < -43 && camera.Pos.x < 84.1 && camera.Pos.x > 68.1) {
-				camera.Pos.z = -44.1;
-			}
-			if (camera.Pos.x > 67.9 && camera.Pos.x < 69 && camera.Pos.z < -11.9 && camera.Pos.z > -44.1) {
-				camera.Pos.x = 67.9;
-			}
-			if (camera.Pos.z > -12.1 && camera.Pos.z < -11 && camera.Pos.x < 68.1 && camera.Pos.x > 19.9) {
-				camera.Pos.z = -12.1;
-			}
-			//L Hall
-			if (camera.Pos.x > 19.9 && camera.Pos.x < 21 && camera.Pos.z < 52.1 && camera.Pos.z > -12.1) {
-				camera.Pos.x = 19.9;
-			}
-			if (camera.Pos.z < 52.1 && camera.Pos.z > 51 && camera.Pos.x < 52.1 && camera.Pos.x > 20.1) {
-				camera.Pos.z = 52.1;
-			}
-			if (camera.Pos.x > 51.9 && camera.Pos.x < 53 && camera.Pos.z < 60.1 && camera.Pos.z > 51.9) {
-				camera.Pos.x = 51.9;
-			}
-			if (camera.Pos.z > 59.9 && camera.Pos.z < 61 && camera.Pos.x < 52.1 && camera.Pos.x > 11.9) {
-				camera.Pos.z = 59.9;
-			}
-			if (camera.Pos.x < 12.1 && camera.Pos.x > 11 && camera.Pos.z < 60.1 && camera.Pos.z > 19.9) {
-				camera.Pos.x = 12.1;
-			}
-			//Corner
-			if (camera.Pos.z > 19.9 && camera.Pos.z < 21 && camera.Pos.x < 12.1 && camera.Pos.x >-33.9) {
-				camera.Pos.z = 19.9;
-			}
-			if (camera.Pos.x > -34.1 && camera.Pos.x < -33 && camera.Pos.z < 52.1 && camera.Pos.z > 20.1) {
-				camera.Pos.x = -34.1;
-			}
-			if (camera.Pos.z < 52.1 && camera.Pos.z > 51 && camera.Pos.x < -17.9 && camera.Pos.x >-34.1) {
-				camera.Pos.z = 52.1;
-			}
-			if (camera.Pos.x < -17.9 && camera.Pos.x > -19 && camera.Pos.z < 52.1 && camera.Pos.z >35.9) {
-				camera.Pos.x = -17.9;
-			}
-			if (camera.Pos.z > 35.9 && camera.Pos.z < 37 && camera.Pos.x < -17.9 && camera.Pos.x >-32.1) {
-				camera.Pos.z = 35.9;
-			}
-			if (camera.Pos.x < -31.9 && camera.Pos.x > -33 && camera.Pos.z < 36.1 && camera.Pos.z >29.9) {
-				camera.Pos.x = -31.9;
-			}
-			if (camera.Pos.z < 29.9 && camera.Pos.z > 29 && camera.Pos.x < -9.9 && camera.Pos.x > -32.1) {
-				camera.Pos.z = 29.9;
-			}
-			if (camera.Pos.x > -10.1 && camera.Pos.x < -9 && camera.Pos.z < 60.1 && camera.Pos.z >28.9) {
-				camera.Pos.x = -10.1;
-			}
-			if (camera.Pos.z > 59.9 && camera.Pos.z < 61 && camera.Pos.x < -9.9 && camera.Pos.x >-42.1) {
-				camera.Pos.z = 59.9;
-			}
-			if (camera.Pos.x < -41.9 && camera.Pos.x > -43 && camera.Pos.z < 60.1 && camera.Pos.z >-28.1) {
-				camera.Pos.x = -41.9;
-			}
-			if (camera.Pos.z < -27.9 && camera.Pos.z > -29 && camera.Pos.x < -33.9 && camera.Pos.x >-42.1) {
-				camera.Pos.z = -27.9;
-			}
-			if (camera.Pos.x > -34.1 && camera.Pos.x < -33 && camera.Pos.z < 12.1 && camera.Pos.z >-27.9) {
-				camera.Pos.x = -34.1;
-			}
-			if (camera.Pos.z < 12.1 && camera.Pos.z > 11 && camera.Pos.x < -19.9 && camera.Pos.x >-34.9) {
-				camera.Pos.z = 12.1;
-			}
-			//Hole
-			if (camera.Pos.x > 109.9 && camera.Pos.x < 111 && camera.Pos.z < 60.1 && camera.Pos.z >27.9) {
-				camera.Pos.x = 109.9;
-			}
-			if (camera.Pos.z > 59.9 && camera.Pos.z < 61 && camera.Pos.x < 110.1 && camera.Pos.x >79.9) {
-				camera.Pos.z = 59.9;
-			}
-			if (camera.Pos.x < 80.1 && camera.Pos.x > 79 && camera.Pos.z < 60.1 && camera.Pos.z >27.9) {	
-				camera.Pos.x = 80.1;
-			}
-			if (camera.Pos.z < 28.1 && camera.Pos.z > 27 && camera.Pos.x < 110.1 && camera.Pos.x >79.9) {
-				camera.Pos.z = 28.1;
+	// The render thread: draws the latest snapshot while the simulation builds the next.
+	while (running) {
+		sf::Event ev;
+		while (window.pollEvent(ev)) {
+			if (ev.type == sf::Event::Closed) {
+				running = false;
+				pipeline.close();
 			}
-
+		}
+		const RenderSnapshot* snapshot = pipeline.acquire();
+		if (snapshot == nullptr) {
+			break;
+		}
+		window.clear();
+		viewAspect = static_cast<float_t>(window.getSize().x) / window.getSize().y;
+		const glm::mat4& perspective = snapshot->projection;
+
+		bool intro = snapshot->lighting == lightingShader(scene);
+		if (snapshot->lighting != mainShader) {
+			// Switch to the Game's variant, which has no spotlights to turn off.
+			mainShader = snapshot->lighting;
+			mainShader->activate();
+			mainShader->setUniform("dirLight.direction", glm::vec3(0.0f, -6.0f, 0.0f));
+			mainShader->setUniform("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
+			mainShader->setUniform("dirLight.diffuse", glm::vec3(0.04f, 0.04f, 0.04f));
+			mainShader->setUniform("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+		}
+		if (intro) {
+			mainShader->setUniform("dirLight.direction", glm::vec3(0.0f, -6.0f, 0.0f));
+			mainShader->setUniform("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
+			mainShader->setUniform("dirLight.diffuse", glm::vec3(0.04f, 0.04f, 0.04f));
+			mainShader->setUniform("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+			mainShader->setUniform("spotLight[0].position", glm::vec3(1.5, .45, .7));
+			mainShader->setUniform("spotLight[0].direction", glm::vec3(1, 0, 0));
+			mainShader->setUniform("spotLight[0].ambient", glm::vec3(0, 0, 0));
+			mainShader->setUniform("spotLight[0].diffuse", glm::vec3(1, 1, 1));
+			mainShader->setUniform("spotLight[0].specular", glm::vec3(1, 1, 1));
+			mainShader->setUniform("spotLight[0].constant", 1.0f);
+			mainShader->setUniform("spotLight[0].linear", 0.09f);
+			mainShader->setUniform("spotLight[0].quadratic", 0.032f);
+			mainShader->setUniform("spotLight[0].cutOff", glm::cos(glm::radians(12.5f)));
+			mainShader->setUniform("spotLight[0].outerCutOff", glm::cos(glm::radians(15.0f)));
+			mainShader->setUniform("spotLight[1].position", glm::vec3(1.5, .45, 1.7));
+			mainShader->setUniform("spotLight[1].direction", snapshot->viewFront);
+			mainShader->setUniform("spotLight[1].ambient", glm::vec3(0, 0, 0));
+			mainShader->setUniform("spotLight[1].diffuse", glm::vec3(1, 1, 1));
+			mainShader->setUniform("spotLight[1].specular", glm::vec3(1, 1, 1));
+			mainShader->setUniform("spotLight[1].constant", 1.0f);
+			mainShader->setUniform("spotLight[1].linear", 0.09f);
+			mainShader->setUniform("spotLight[1].quadratic", 0.032f);
+			mainShader->setUniform("spotLight[1].cutOff", glm::cos(glm::radians(12.5f)));
+			mainShader->setUniform("spotLight[1].outerCutOff", glm::cos(glm::radians(15.0f)));
 		}
 
-			// Clear the OpenGL "context".
-			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-			// Render each object in the scene.
-			if (boolscene) {
-				for (auto& obj : scene.objects) {
-					obj.render(window, mainShader);
-				}
+		// Per-frame uniforms go to whichever variant is active for this snapshot.
+		mainShader->setUniform("material", glm::vec4(.1, .5, 1, 32));
+
+		// Clear the OpenGL "context".
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (!intro) {
+			gameLights.clear();
+			for (auto& light : snapshot->lights) {
+				gameLights.addLight(light);
 			}
-			if (boolscene1) {
-				for (auto& obj : scene1.objects) {
-					obj.render(window, mainShader);
-				}
+			for (auto& light : snapshot->spotLights) {
+				gameLights.addLight(light);
 			}
-			//std::cout << 1 / diff.asSeconds() << " FPS " << std::endl;
-			window.display();
+			gameLights.update(snapshot->view, perspective, NEAR_PLANE, FAR_PLANE);
+			gameLights.bind(*mainShader, window.getSize().x, window.getSize().y);
 		}
-
-		return 0;
+		renderer.render(window, *snapshot, *mainShader, perspective);
+		//std::cout << 1 / diff.asSeconds() << " FPS " << std::endl;
+		window.display();
 	}
 
-
-
+	simulationThread.join();
+	return 0;
+}
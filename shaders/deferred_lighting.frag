@@ -0,0 +1,31 @@
+#version 330
+// The lighting pass of deferred shading: runs once per screen pixel, reading the surface
+// from the G-buffer and applying the same lights as multilights.frag.
+layout (location=0) out vec4 FragColor;
+
+in vec2 TexCoord;
+
+#include "lights.glsl"
+
+uniform sampler2D gAlbedo;
+uniform sampler2D gNormal;
+uniform sampler2D gDepth;
+
+// Maps clip space back to world space, to rebuild each pixel's position from its depth.
+uniform mat4 inverseViewProjection;
+uniform vec3 viewPos;
+
+void main() {
+    float depth = texture(gDepth, TexCoord).r;
+    if (depth == 1.0) {
+        // Nothing was drawn here; keep the cleared background.
+        discard;
+    }
+    vec4 world = inverseViewProjection * vec4(vec3(TexCoord, depth) * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 norm = normalize(texture(gNormal, TexCoord).xyz);
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 result = CalcLighting(norm, fragPos, viewDir);
+    FragColor = vec4(result, 1.0) * texture(gAlbedo, TexCoord);
+}
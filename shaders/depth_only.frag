@@ -0,0 +1,4 @@
+#version 330
+// A fragment shader for the depth pre-pass. Colour writes are masked off; only depth matters.
+void main() {
+}
@@ -0,0 +1,15 @@
+#version 330
+// A vertex shader for the depth pre-pass: positions only. The transform must match
+// light_perspective.vert exactly, so both are declared invariant; the lighting pass then
+// draws with GL_EQUAL against the depths written here.
+layout (location=0) in vec3 vPosition;
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+
+invariant gl_Position;
+
+void main() {
+    gl_Position = projection * view * model * vec4(vPosition, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 330
+// A vertex shader that covers the screen with one triangle and needs no vertex buffer:
+// draw 3 vertices with any (empty) vertex array bound.
+out vec2 TexCoord;
+
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    TexCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
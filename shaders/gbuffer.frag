@@ -0,0 +1,17 @@
+#version 330
+// The geometry pass of deferred shading: writes each visible surface's base colour and
+// world-space normal to the G-buffer. Depth comes from the depth attachment, and lighting
+// happens later in deferred_lighting.frag.
+layout (location=0) out vec4 AlbedoOut;
+layout (location=1) out vec3 NormalOut;
+
+in vec2 TexCoord;
+in vec3 Normal;
+in vec3 FragWorldPos;
+
+uniform sampler2D baseTexture;
+
+void main() {
+    AlbedoOut = texture(baseTexture, TexCoord);
+    NormalOut = normalize(Normal);
+}
@@ -8,16 +8,21 @@ layout (location=2) in vec2 vTexCoord;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+// The inverse transpose of model's upper 3x3, computed on the CPU once per object.
+uniform mat3 normalMatrix;
 
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragWorldPos;
 
+// Must produce the same depths as depth_only.vert for the depth pre-pass.
+invariant gl_Position;
+
 void main() {
     // Transform the position to clip space.
     gl_Position = projection * view * model * vec4(vPosition, 1.0);
     TexCoord = vTexCoord;
-    Normal = mat3(transpose(inverse(model))) * vNormal;
+    Normal = normalMatrix * vNormal;
 
     // Transform the vertex position into world space, and assign it to FragWorldPos.
     FragWorldPos = vec3(model * vec4(vPosition, 1.0));
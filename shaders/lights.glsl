@@ -0,0 +1,184 @@
+// Light types and the Phong lighting math shared by every lit fragment shader
+// (multilights.frag for forward shading, deferred_lighting.frag for deferred shading).
+// Pulled in with #include "lights.glsl", which ShaderProgram resolves at load time.
+
+struct DirLight{
+	vec3 direction;
+	vec3 diffuse;
+	vec3 ambient;
+	vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+  
+    float constant;
+    float linear;
+    float quadratic;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;       
+};
+
+struct PointLight {
+    vec3 position;
+    
+    float constant;
+    float linear;
+    float quadratic;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+// Permutation switches. The application may inject any of these with ShaderProgram::variant;
+// otherwise the defaults below apply. Light types with a count of 0 are compiled out entirely.
+#ifndef NR_DIR_LIGHTS
+#define NR_DIR_LIGHTS 1
+#endif
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 1
+#endif
+#ifndef NR_SPOT_LIGHTS
+#define NR_SPOT_LIGHTS 2
+#endif
+#ifndef CLUSTERED_LIGHTING
+#define CLUSTERED_LIGHTING 0
+#endif
+
+#if NR_SPOT_LIGHTS > 0
+uniform SpotLight spotLight[NR_SPOT_LIGHTS];
+#endif
+#if NR_POINT_LIGHTS > 0
+uniform PointLight pointLight[NR_POINT_LIGHTS];
+#endif
+#if NR_DIR_LIGHTS > 0
+uniform DirLight dirLight;
+#endif
+
+#if CLUSTERED_LIGHTING
+// Point and spot lights binned by ClusteredLights: 5 texels per light, (offset, count) per
+// cluster, and the packed list of light indices the offsets point into. Lights below
+// clusterPointLights are point lights; the rest are spot lights.
+uniform samplerBuffer clusterLights;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterIndices;
+uniform int clusterPointLights;
+uniform vec3 clusterDims;
+uniform vec2 clusterDepth; // near, far
+uniform vec2 screenSize;
+uniform mat4 view;
+#endif
+
+uniform vec4 material;
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+
+// Sums the contribution of every light enabled in this variant at the given world position.
+vec3 CalcLighting(vec3 norm, vec3 fragPos, vec3 viewDir) {
+	vec3 result = vec3(0.0);
+#if NR_DIR_LIGHTS > 0
+	result += CalcDirLight(dirLight, norm, viewDir);
+#endif
+#if NR_POINT_LIGHTS > 0
+	for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+		result += CalcPointLight(pointLight[i], norm, fragPos, viewDir);
+	}
+#endif
+#if CLUSTERED_LIGHTING
+	// Find this fragment's cluster: screen tile in x/y, exponential depth slice in z.
+	float depth = -(view * vec4(fragPos, 1.0)).z;
+	int slice = int(log(depth / clusterDepth.x) / log(clusterDepth.y / clusterDepth.x) * clusterDims.z);
+	ivec3 cluster = clamp(ivec3(ivec2(gl_FragCoord.xy / screenSize * clusterDims.xy), slice),
+		ivec3(0), ivec3(clusterDims) - 1);
+	int clusterIndex = cluster.x + int(clusterDims.x) * (cluster.y + int(clusterDims.y) * cluster.z);
+	uvec2 range = texelFetch(clusterGrid, clusterIndex).xy;
+	for (uint i = 0u; i < range.y; i++) {
+		int index = int(texelFetch(clusterIndices, int(range.x + i)).x);
+		int light = index * 5;
+		vec4 t0 = texelFetch(clusterLights, light);
+		vec4 t1 = texelFetch(clusterLights, light + 1);
+		vec4 t2 = texelFetch(clusterLights, light + 2);
+		vec4 t3 = texelFetch(clusterLights, light + 3);
+		if (index < clusterPointLights) {
+			PointLight p = PointLight(t0.xyz, t0.w, t1.w, t2.w, t1.xyz, t2.xyz, t3.xyz);
+			result += CalcPointLight(p, norm, fragPos, viewDir);
+		}
+		else {
+			vec4 t4 = texelFetch(clusterLights, light + 4);
+			SpotLight s = SpotLight(t0.xyz, t4.xyz, t3.w, t4.w, t0.w, t1.w, t2.w, t1.xyz, t2.xyz, t3.xyz);
+			result += CalcSpotLight(s, norm, fragPos, viewDir);
+		}
+	}
+#endif
+#if NR_SPOT_LIGHTS > 0
+	for (int i = 0; i < NR_SPOT_LIGHTS; i++) {
+		result += CalcSpotLight(spotLight[i], norm, fragPos, viewDir);
+	}
+#endif
+	return result;
+}
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir){
+	vec3 lightDir = normalize(-light.direction);
+	float diff = max(dot(normal, lightDir), 0.0);
+	vec3 reflectDir = reflect(-lightDir, normal);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.w);
+	vec3 ambient = light.ambient * material.y;
+	vec3 diffuse = light.diffuse * diff * material.y;
+	vec3 specular = light.specular * spec * material.z;
+     
+	return(ambient + diffuse + specular);
+}
+
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.w);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // spotlight intensity
+    float theta = dot(lightDir, normalize(-light.direction)); 
+    float epsilon = light.cutOff - light.outerCutOff;
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    // combine results
+    vec3 ambient = light.ambient * material.y;
+    vec3 diffuse = light.diffuse * diff * material.y;
+    vec3 specular = light.specular * spec * material.z;
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity;
+    specular *= attenuation * intensity;
+    return (ambient + diffuse + specular);
+}
+
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir){
+    vec3 lightDir = normalize(light.position - fragPos);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.w);
+    // attenuation
+    float distance = length(light.position - fragPos);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // combine results
+    vec3 ambient = light.ambient * material.y;
+    vec3 diffuse = light.diffuse * diff * material.y;
+    vec3 specular = light.specular * spec * material.z;
+    ambient *= attenuation;
+    diffuse *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
@@ -0,0 +1,45 @@
+#version 330
+// A vertex shader for skinned meshes: each vertex is moved by a weighted blend of up to four
+// bone matrices, then transformed like light_perspective.vert. Pairs with multilights.frag.
+layout (location=0) in vec3 vPosition;
+layout (location=1) in vec3 vNormal;
+layout (location=2) in vec2 vTexCoord;
+layout (location=3) in ivec4 vBoneIds;
+layout (location=4) in vec4 vBoneWeights;
+
+// Set to the model's bone count by SkinnedModel::shaderDefines; the default is Skeleton::MAX_BONES.
+#ifndef MAX_BONES
+#define MAX_BONES 256
+#endif
+
+// The skinning matrix of each bone, uploaded once per model by SkinnedModel.
+layout (std140) uniform Bones {
+    mat4 bones[MAX_BONES];
+};
+
+uniform mat4 projection;
+uniform mat4 view;
+uniform mat4 model;
+uniform mat3 normalMatrix;
+
+out vec2 TexCoord;
+out vec3 Normal;
+out vec3 FragWorldPos;
+
+void main() {
+    // Whatever weight the bones leave unclaimed stays with the bind pose, so vertices that no
+    // bone influences do not collapse to the origin.
+    float boneTotal = dot(vBoneWeights, vec4(1.0));
+    mat4 skin = bones[vBoneIds.x] * vBoneWeights.x
+        + bones[vBoneIds.y] * vBoneWeights.y
+        + bones[vBoneIds.z] * vBoneWeights.z
+        + bones[vBoneIds.w] * vBoneWeights.w
+        + mat4(1.0) * (1.0 - boneTotal);
+
+    vec4 skinnedPosition = skin * vec4(vPosition, 1.0);
+    gl_Position = projection * view * model * skinnedPosition;
+    TexCoord = vTexCoord;
+    // Bones are close to rigid, so their upper 3x3 transforms normals well enough.
+    Normal = normalMatrix * (mat3(skin) * vNormal);
+    FragWorldPos = vec3(model * skinnedPosition);
+}
@@ -7,6 +7,8 @@ layout (location=2) in vec2 vTexCoord;
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
+// The inverse transpose of model's upper 3x3, computed on the CPU once per object.
+uniform mat3 normalMatrix;
 
 out vec2 TexCoord;
 out vec3 Normal;
@@ -17,6 +19,5 @@ void main() {
     TexCoord = vTexCoord;
 
     // Transform the vertex normal to world space using the normal matrix.
-    mat4 normalMatrix = transpose(inverse(model));
-    Normal = mat3(normalMatrix) * vNormal;
+    Normal = normalMatrix * vNormal;
 }
\ No newline at end of file